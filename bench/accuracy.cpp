@@ -0,0 +1,593 @@
+// Accuracy report of the solvers, to tell whether a change of the hot paths
+// (integrators, reordered math, compiler flags) is acceptable.
+//
+// Short horizon: the float solvers start from points on the attractor and are compared,
+// sample by sample, with a double precision RK4 reference. The error is the largest
+// output difference in volts, reported with the cost of each integrator.
+//
+// Long horizon: chaotic solutions diverge anyway, so the modules are compared through
+// statistics of their outputs, which depend on the attractor and not on the trajectory:
+// bounding box, mean, RMS and spectral centroid. They are reported next to the ones of the
+// reference, and with --compare, checked against a previous run.
+//
+// Slow rates: at the bottom of the LF range, the float state and the double precision one
+// the modules switch to are compared with a double precision RK4 reference over the same
+// time of the system, which takes up to a million samples.
+#include "bench.hpp"
+#include <chrono>
+#include <cmath>
+
+
+static const float SAMPLE_RATE = 48000.f;
+static const int TRIALS = 20;
+static const int SHORT_HORIZON = 100;           // samples
+static const int SHORT_REFERENCE_STEPS = 100;   // RK4 steps per sample
+static const int LONG_HORIZON = 10;             // seconds
+static const int LONG_SETTLE = 1;               // seconds skipped at the start
+static const int LONG_REFERENCE_STEPS = 16;
+static const int FFT_LEN = 1024;
+static const double SLOW_TIME = 2.0;            // time of the system
+static const int SLOW_REFERENCE_STEPS = 16;
+
+
+struct ErrorResult {
+    std::string system;
+    std::string integrator;
+    bool adaptive;
+    float rate;
+    double error;           // V, mean over the trials of the largest output difference
+    double evalsPerSample;
+    double nsPerSample;     // one float_4 block of 4 voices
+};
+
+struct PrecisionResult {
+    std::string system;
+    float rate;             // LF range
+    long samples;
+    double floatError;      // V, largest output difference
+    double preciseError;
+    double floatNs;         // one float_4 block of 4 voices
+    double preciseNs;
+};
+
+struct Statistics {
+    double min, max, mean, rms, centroid;
+};
+
+struct InvariantResult {
+    std::string model;
+    std::string integrator;
+    Statistics axes[3];
+    Statistics reference[3];
+    bool compared = false;
+    bool pass = true;
+};
+
+
+/** Coefficients of the knobs at their default position */
+template <class System, typename T>
+static void defaultCoefficients(T* k) {
+    for (int i = 0; i < System::NUM_COEFFS; i++) {
+        const ParamMap m = System::paramMap(i);
+        k[i] = clamp(0.5f * m.scale + m.offset, m.min, m.max);
+    }
+}
+
+/** Time advanced per sample by the modules in HF range with the Rate knob at `rate` */
+template <class System>
+static double sampleTime(float rate) {
+    return (double) (rate * System::RATE_HF / SAMPLE_RATE) * System::SUBSTEPS_HF;
+}
+
+
+/** Reference trajectories of the short horizon, TRIALS runs of SHORT_HORIZON samples */
+template <class System>
+struct ShortReference {
+    double k[System::NUM_COEFFS];
+    Vec3<double> start[TRIALS];
+    Vec3<double> path[TRIALS][SHORT_HORIZON];
+
+    ShortReference(float rate) {
+        defaultCoefficients<System>(k);
+        double h = sampleTime<System>(rate) / SHORT_REFERENCE_STEPS;
+        Vec3<double> s = System::template initial<double>();
+        // Onto the attractor, then the trials start 500 samples apart
+        for (int i = 0; i < 5000 * SHORT_REFERENCE_STEPS; i++)
+            RK4Integrator::step<System>(s, k, h);
+        for (int t = 0; t < TRIALS; t++) {
+            for (int i = 0; i < 500 * SHORT_REFERENCE_STEPS; i++)
+                RK4Integrator::step<System>(s, k, h);
+            start[t] = s;
+            Vec3<double> r = s;
+            for (int i = 0; i < SHORT_HORIZON; i++) {
+                for (int j = 0; j < SHORT_REFERENCE_STEPS; j++)
+                    RK4Integrator::step<System>(r, k, h);
+                path[t][i] = r;
+            }
+        }
+    }
+};
+
+
+template <class System, class Integrator>
+static ErrorResult shortHorizon(const ShortReference<System>& ref, const char* system, const char* integrator, float rate, bool adaptive) {
+    typedef Attractor<System, Integrator, 1> Solver;
+    float k[System::NUM_COEFFS];
+    defaultCoefficients<System>(k);
+    float dt = sampleTime<System>(rate);
+
+    // Error, in the same order of operations as ChaosModule::processVoices
+    double errorSum = 0.0;
+    long evals = 0;
+    for (int t = 0; t < TRIALS; t++) {
+        Vec3<float> s{(float) ref.start[t].x, (float) ref.start[t].y, (float) ref.start[t].z};
+        int n = System::SUBSTEPS_HF;
+        double error = 0.0;
+        for (int i = 0; i < SHORT_HORIZON; i++) {
+            Vec3<float> s0 = s;
+            float h = rate * System::RATE_HF / SAMPLE_RATE;
+            if (adaptive)
+                h *= (float) System::SUBSTEPS_HF / n;
+            Solver::integrate(s, k, h, n);
+            evals += n * Integrator::EVALS;
+            if (adaptive && i % 16 == 0)
+                n = Solver::adaptiveSubsteps(s0, s, k);
+
+            const Vec3<double>& r = ref.path[t][i];
+            Vec3<double> d = System::output(Vec3<double>{s.x - r.x, s.y - r.y, s.z - r.z});
+            error = std::max(error, std::max(std::fabs(d.x), std::max(std::fabs(d.y), std::fabs(d.z))));
+        }
+        errorSum += error;
+    }
+
+    // Cost of a float_4 block, as in the module
+    typedef Attractor<System, Integrator> Solver4;
+    AttractorState<simd::float_4> st;
+    Solver4::init(st);
+    simd::float_4 k4[System::NUM_COEFFS];
+    for (int i = 0; i < System::NUM_COEFFS; i++)
+        k4[i] = k[i];
+    const int samples = (int) SAMPLE_RATE;
+    int n = System::SUBSTEPS_HF;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) {
+        Vec3<simd::float_4> s0 = st.s;
+        simd::float_4 h = dt / n;
+        Solver4::process(st, k4, h, n, simd::float_4::zero());
+        if (adaptive && i % 16 == 0)
+            n = Solver4::adaptiveSubsteps(s0, st.s, k4);
+    }
+    auto end = std::chrono::steady_clock::now();
+    // Keep the loop from being optimized out
+    volatile float sink = st.postDC.x[0];
+    (void) sink;
+
+    ErrorResult result;
+    result.system = system;
+    result.integrator = integrator;
+    result.adaptive = adaptive;
+    result.rate = rate;
+    result.error = errorSum / TRIALS;
+    result.evalsPerSample = (double) evals / (TRIALS * SHORT_HORIZON);
+    result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / samples;
+    return result;
+}
+
+
+template <class System>
+static void shortHorizons(const char* system, std::vector<ErrorResult>& results) {
+    const float rates[] = {1.f, 0.5f, 0.1f};
+    for (float rate : rates) {
+        ShortReference<System>* ref = new ShortReference<System>(rate);
+        for (int adaptive = 0; adaptive < 2; adaptive++) {
+            results.push_back(shortHorizon<System, EulerIntegrator>(*ref, system, INTEGRATOR_NAMES[0], rate, adaptive));
+            results.push_back(shortHorizon<System, HeunIntegrator>(*ref, system, INTEGRATOR_NAMES[1], rate, adaptive));
+            results.push_back(shortHorizon<System, RK4Integrator>(*ref, system, INTEGRATOR_NAMES[2], rate, adaptive));
+            results.push_back(shortHorizon<System, SemiImplicitIntegrator>(*ref, system, INTEGRATOR_NAMES[3], rate, adaptive));
+        }
+        delete ref;
+    }
+}
+
+
+static double lane0(simd::float_4 v) {
+    return v[0];
+}
+
+static double lane0(const Double4& v) {
+    return v.v[0];
+}
+
+/** Largest output error of Euler steps from `start` over SLOW_TIME with lanes of type T,
+against `reference`, and its cost per sample
+*/
+template <class System, int Lanes>
+static void slowPath(const Vec3<double>& start, const std::vector<Vec3<double>>& reference, float h, double& error, double& ns) {
+    typedef Attractor<System, EulerIntegrator, Lanes> Solver;
+    typedef typename LaneType<Lanes>::type T;
+    T k[System::NUM_COEFFS];
+    defaultCoefficients<System>(k);
+    AttractorState<T> st;
+    Solver::init(st);
+    st.s = Vec3<T>{(float) start.x, (float) start.y, (float) start.z};
+
+    error = 0.0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < reference.size(); i++) {
+        Solver::process(st, k, T(h), 1, simd::float_4::zero());
+        const Vec3<double>& r = reference[i];
+        Vec3<double> d = System::output(Vec3<double>{lane0(st.s.x) - r.x, lane0(st.s.y) - r.y, lane0(st.s.z) - r.z});
+        error = std::max(error, std::max(std::fabs(d.x), std::max(std::fabs(d.y), std::fabs(d.z))));
+    }
+    auto end = std::chrono::steady_clock::now();
+    ns = std::chrono::duration<double, std::nano>(end - begin).count() / reference.size();
+}
+
+
+template <class System>
+static void slowRates(const char* system, std::vector<PrecisionResult>& results) {
+    double k[System::NUM_COEFFS];
+    defaultCoefficients<System>(k);
+    // Onto the attractor
+    Vec3<double> start = System::template initial<double>();
+    double hStart = sampleTime<System>(0.5f) / 16;
+    for (int i = 0; i < 5000 * 16; i++)
+        RK4Integrator::step<System>(start, k, hStart);
+
+    const float rates[] = {0.1f, 0.01f, 0.001f};
+    for (float rate : rates) {
+        float h = rate * System::RATE_LF / SAMPLE_RATE;
+        long samples = (long) std::ceil(SLOW_TIME / h);
+        std::vector<Vec3<double>> reference(samples);
+        Vec3<double> r{(float) start.x, (float) start.y, (float) start.z};
+        double hRef = (double) h / SLOW_REFERENCE_STEPS;
+        for (long i = 0; i < samples; i++) {
+            for (int j = 0; j < SLOW_REFERENCE_STEPS; j++)
+                RK4Integrator::step<System>(r, k, hRef);
+            reference[i] = r;
+        }
+
+        PrecisionResult result;
+        result.system = system;
+        result.rate = rate;
+        result.samples = samples;
+        slowPath<System, 4>(start, reference, h, result.floatError, result.floatNs);
+        slowPath<System, PRECISE_LANES>(start, reference, h, result.preciseError, result.preciseNs);
+        results.push_back(result);
+    }
+}
+
+
+/** Bounding box, mean, RMS and, from Hann windowed frames, the spectral centroid of a signal */
+struct StatisticsAccumulator {
+    double min = INFINITY;
+    double max = -INFINITY;
+    double sum = 0.0;
+    double sum2 = 0.0;
+    long count = 0;
+    alignas(16) float frame[FFT_LEN];
+    alignas(16) float spectrum[FFT_LEN];
+    double power[FFT_LEN / 2] = {};
+    int framePos = 0;
+    dsp::RealFFT fft{FFT_LEN};
+
+    void process(double x) {
+        min = std::min(min, x);
+        max = std::max(max, x);
+        sum += x;
+        sum2 += x * x;
+        count++;
+
+        frame[framePos] = x * (0.5 - 0.5 * std::cos(2.0 * M_PI * framePos / FFT_LEN));
+        if (++framePos == FFT_LEN) {
+            fft.rfft(frame, spectrum);
+            for (int i = 1; i < FFT_LEN / 2; i++)
+                power[i] += spectrum[2 * i] * spectrum[2 * i] + spectrum[2 * i + 1] * spectrum[2 * i + 1];
+            framePos = 0;
+        }
+    }
+
+    Statistics get() {
+        Statistics s;
+        s.min = min;
+        s.max = max;
+        s.mean = sum / count;
+        s.rms = std::sqrt(sum2 / count);
+        double weighted = 0.0;
+        double total = 0.0;
+        for (int i = 1; i < FFT_LEN / 2; i++) {
+            weighted += i * power[i];
+            total += power[i];
+        }
+        s.centroid = (total > 0.0) ? weighted / total * SAMPLE_RATE / FFT_LEN : 0.0;
+        return s;
+    }
+};
+
+
+/** Long horizon statistics of the outputs of a double precision RK4 solution, going
+through the same DC blocker and output scaling as the modules
+*/
+template <class System>
+static void longReference(Statistics* stats) {
+    double k[System::NUM_COEFFS];
+    defaultCoefficients<System>(k);
+    double h = sampleTime<System>(0.5f) / LONG_REFERENCE_STEPS;
+    Vec3<double> s = System::template initial<double>();
+    Vec3<double> pre{0.0, 0.0, 0.0};
+    Vec3<double> post{0.0, 0.0, 0.0};
+    StatisticsAccumulator* acc = new StatisticsAccumulator[3];
+    for (int i = 0; i < LONG_HORIZON * (int) SAMPLE_RATE; i++) {
+        for (int j = 0; j < LONG_REFERENCE_STEPS; j++)
+            RK4Integrator::step<System>(s, k, h);
+        post.x = s.x - pre.x + 0.9999 * post.x;
+        post.y = s.y - pre.y + 0.9999 * post.y;
+        post.z = s.z - pre.z + 0.9999 * post.z;
+        pre = s;
+        if (i < LONG_SETTLE * (int) SAMPLE_RATE)
+            continue;
+        Vec3<double> out = System::output(post);
+        acc[0].process(out.x);
+        acc[1].process(out.y);
+        acc[2].process(out.z);
+    }
+    for (int a = 0; a < 3; a++)
+        stats[a] = acc[a].get();
+    delete[] acc;
+}
+
+
+/** Long horizon statistics of the outputs of a module, HF range, Rate at half, other knobs at default */
+static void longModule(Model* model, int integrator, Statistics* stats) {
+    Module* m = model->createModule();
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "integrator", json_integer(integrator));
+    m->dataFromJson(rootJ);
+    json_decref(rootJ);
+    m->params[Ids::RATE_PARAM].setValue(0.5f);
+    for (int i = 0; i < Ids::OUTPUTS_LEN; i++)
+        m->outputs[i].channels = 1;
+
+    Module::ProcessArgs args;
+    args.sampleRate = SAMPLE_RATE;
+    args.sampleTime = 1.f / SAMPLE_RATE;
+    args.frame = 0;
+    StatisticsAccumulator* acc = new StatisticsAccumulator[3];
+    for (int i = 0; i < LONG_HORIZON * (int) SAMPLE_RATE; i++, args.frame++) {
+        m->process(args);
+        if (i < LONG_SETTLE * (int) SAMPLE_RATE)
+            continue;
+        for (int a = 0; a < 3; a++)
+            acc[a].process(m->outputs[Ids::X_OUTPUT + a].getVoltage());
+    }
+    for (int a = 0; a < 3; a++)
+        stats[a] = acc[a].get();
+    delete[] acc;
+    delete m;
+}
+
+
+static bool longReferenceOf(const std::string& slug, Statistics* stats) {
+    if (slug == "JulioChua")
+        longReference<Chua>(stats);
+    else if (slug == "JulioRossler")
+        longReference<Rossler>(stats);
+    else if (slug == "JulioLorentz84")
+        longReference<Lorentz84>(stats);
+    else
+        return false;
+    return true;
+}
+
+
+static const char* AXIS_NAMES[] = {"X", "Y", "Z"};
+
+static json_t* statisticsToJson(const Statistics& s) {
+    json_t* statsJ = json_object();
+    json_object_set_new(statsJ, "min", json_real(s.min));
+    json_object_set_new(statsJ, "max", json_real(s.max));
+    json_object_set_new(statsJ, "mean", json_real(s.mean));
+    json_object_set_new(statsJ, "rms", json_real(s.rms));
+    json_object_set_new(statsJ, "centroid", json_real(s.centroid));
+    return statsJ;
+}
+
+static Statistics statisticsFromJson(json_t* statsJ) {
+    Statistics s;
+    s.min = json_number_value(json_object_get(statsJ, "min"));
+    s.max = json_number_value(json_object_get(statsJ, "max"));
+    s.mean = json_number_value(json_object_get(statsJ, "mean"));
+    s.rms = json_number_value(json_object_get(statsJ, "rms"));
+    s.centroid = json_number_value(json_object_get(statsJ, "centroid"));
+    return s;
+}
+
+/** Bounding box and mean relative to the size of the box, RMS and centroid relative to themselves */
+static bool withinTolerance(const Statistics& s, const Statistics& ref, float tolerance) {
+    double range = ref.max - ref.min;
+    return std::fabs(s.min - ref.min) <= tolerance * range
+        && std::fabs(s.max - ref.max) <= tolerance * range
+        && std::fabs(s.mean - ref.mean) <= tolerance * range
+        && std::fabs(s.rms - ref.rms) <= tolerance * ref.rms
+        && std::fabs(s.centroid - ref.centroid) <= tolerance * ref.centroid;
+}
+
+
+/** Checks the invariants against the ones of the same model and integrator in a previous run */
+static void compare(std::vector<InvariantResult>& results, json_t* previousJ, float tolerance) {
+    json_t* invariantsJ = json_object_get(previousJ, "invariants");
+    size_t i;
+    json_t* invariantJ;
+    json_array_foreach(invariantsJ, i, invariantJ) {
+        const char* model = json_string_value(json_object_get(invariantJ, "model"));
+        const char* integrator = json_string_value(json_object_get(invariantJ, "integrator"));
+        if (!model || !integrator)
+            continue;
+        for (InvariantResult& r : results) {
+            if (r.model != model || r.integrator != integrator)
+                continue;
+            json_t* axesJ = json_object_get(invariantJ, "axes");
+            for (int a = 0; a < 3; a++) {
+                json_t* axisJ = json_array_get(axesJ, a);
+                if (!axisJ)
+                    continue;
+                r.compared = true;
+                if (!withinTolerance(r.axes[a], statisticsFromJson(axisJ), tolerance))
+                    r.pass = false;
+            }
+        }
+    }
+}
+
+
+static void writeJson(const std::vector<ErrorResult>& errors, const std::vector<PrecisionResult>& precision, const std::vector<InvariantResult>& invariants, const std::string& path) {
+    json_t* rootJ = json_object();
+    json_t* errorsJ = json_array();
+    for (const ErrorResult& r : errors) {
+        json_t* resultJ = json_object();
+        json_object_set_new(resultJ, "system", json_string(r.system.c_str()));
+        json_object_set_new(resultJ, "integrator", json_string(r.integrator.c_str()));
+        json_object_set_new(resultJ, "adaptive", json_boolean(r.adaptive));
+        json_object_set_new(resultJ, "rate", json_real(r.rate));
+        json_object_set_new(resultJ, "error", json_real(r.error));
+        json_object_set_new(resultJ, "evalsPerSample", json_real(r.evalsPerSample));
+        json_object_set_new(resultJ, "nsPerSample", json_real(r.nsPerSample));
+        json_array_append_new(errorsJ, resultJ);
+    }
+    json_object_set_new(rootJ, "shortHorizon", errorsJ);
+
+    json_t* precisionJ = json_array();
+    for (const PrecisionResult& r : precision) {
+        json_t* resultJ = json_object();
+        json_object_set_new(resultJ, "system", json_string(r.system.c_str()));
+        json_object_set_new(resultJ, "rate", json_real(r.rate));
+        json_object_set_new(resultJ, "samples", json_integer(r.samples));
+        json_object_set_new(resultJ, "floatError", json_real(r.floatError));
+        json_object_set_new(resultJ, "preciseError", json_real(r.preciseError));
+        json_object_set_new(resultJ, "floatNsPerSample", json_real(r.floatNs));
+        json_object_set_new(resultJ, "preciseNsPerSample", json_real(r.preciseNs));
+        json_array_append_new(precisionJ, resultJ);
+    }
+    json_object_set_new(rootJ, "slowRates", precisionJ);
+
+    json_t* invariantsJ = json_array();
+    for (const InvariantResult& r : invariants) {
+        json_t* resultJ = json_object();
+        json_object_set_new(resultJ, "model", json_string(r.model.c_str()));
+        json_object_set_new(resultJ, "integrator", json_string(r.integrator.c_str()));
+        json_t* axesJ = json_array();
+        json_t* referenceJ = json_array();
+        for (int a = 0; a < 3; a++) {
+            json_array_append_new(axesJ, statisticsToJson(r.axes[a]));
+            json_array_append_new(referenceJ, statisticsToJson(r.reference[a]));
+        }
+        json_object_set_new(resultJ, "axes", axesJ);
+        json_object_set_new(resultJ, "reference", referenceJ);
+        if (r.compared)
+            json_object_set_new(resultJ, "pass", json_boolean(r.pass));
+        json_array_append_new(invariantsJ, resultJ);
+    }
+    json_object_set_new(rootJ, "invariants", invariantsJ);
+
+    if (json_dump_file(rootJ, path.c_str(), JSON_INDENT(2)) < 0)
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+    json_decref(rootJ);
+}
+
+
+static void writeCsv(const std::vector<ErrorResult>& errors, const std::vector<PrecisionResult>& precision, const std::vector<InvariantResult>& invariants, const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return;
+    }
+    fprintf(f, "system,integrator,adaptive,rate,error,evalsPerSample,nsPerSample\n");
+    for (const ErrorResult& r : errors)
+        fprintf(f, "%s,%s,%d,%g,%.6g,%.3f,%.2f\n", r.system.c_str(), r.integrator.c_str(), r.adaptive, r.rate, r.error, r.evalsPerSample, r.nsPerSample);
+    fprintf(f, "\nsystem,rate,samples,floatError,preciseError,floatNsPerSample,preciseNsPerSample\n");
+    for (const PrecisionResult& r : precision)
+        fprintf(f, "%s,%g,%ld,%.6g,%.6g,%.2f,%.2f\n", r.system.c_str(), r.rate, r.samples, r.floatError, r.preciseError, r.floatNs, r.preciseNs);
+    fprintf(f, "\nmodel,integrator,axis,min,max,mean,rms,centroid,refMin,refMax,refMean,refRms,refCentroid\n");
+    for (const InvariantResult& r : invariants) {
+        for (int a = 0; a < 3; a++) {
+            const Statistics& s = r.axes[a];
+            const Statistics& ref = r.reference[a];
+            fprintf(f, "%s,%s,%s,%.4f,%.4f,%.4f,%.4f,%.1f,%.4f,%.4f,%.4f,%.4f,%.1f\n", r.model.c_str(), r.integrator.c_str(), AXIS_NAMES[a],
+                s.min, s.max, s.mean, s.rms, s.centroid, ref.min, ref.max, ref.mean, ref.rms, ref.centroid);
+        }
+    }
+    std::fclose(f);
+}
+
+
+int accuracy(Plugin* p, const Options& options) {
+    std::vector<ErrorResult> errors;
+    shortHorizons<Chua>("Chua", errors);
+    shortHorizons<Rossler>("Rossler", errors);
+    shortHorizons<Lorentz84>("Lorentz84", errors);
+
+    printf("Short horizon, %d samples at %g Hz from %d points on the attractor, knobs at default\n", SHORT_HORIZON, SAMPLE_RATE, TRIALS);
+    printf("%-10s %-14s %-9s %6s %12s %14s %12s\n", "system", "integrator", "substeps", "rate", "error V", "evals/sample", "ns/sample");
+    for (const ErrorResult& r : errors)
+        printf("%-10s %-14s %-9s %6g %12.3g %14.2f %12.1f\n", r.system.c_str(), r.integrator.c_str(), r.adaptive ? "adaptive" : "fixed", r.rate, r.error, r.evalsPerSample, r.nsPerSample);
+
+    std::vector<PrecisionResult> precision;
+    slowRates<Chua>("Chua", precision);
+    slowRates<Rossler>("Rossler", precision);
+    slowRates<Lorentz84>("Lorentz84", precision);
+
+    printf("\nSlow rates, LF range, Euler over %g of system time, float and double precision state\n", SLOW_TIME);
+    printf("%-10s %6s %9s %14s %14s %14s %14s\n", "system", "rate", "samples", "float V", "double V", "float ns", "double ns");
+    for (const PrecisionResult& r : precision)
+        printf("%-10s %6g %9ld %14.3g %14.3g %14.1f %14.1f\n", r.system.c_str(), r.rate, r.samples, r.floatError, r.preciseError, r.floatNs, r.preciseNs);
+
+    std::vector<InvariantResult> invariants;
+    for (Model* model : p->models) {
+        if (!options.model.empty() && model->slug != options.model)
+            continue;
+        Statistics reference[3];
+        if (!longReferenceOf(model->slug, reference))
+            continue;
+        for (int integrator = 0; integrator < Ids::INTEGRATORS_LEN; integrator++) {
+            InvariantResult r;
+            r.model = model->slug;
+            r.integrator = INTEGRATOR_NAMES[integrator];
+            longModule(model, integrator, r.axes);
+            for (int a = 0; a < 3; a++)
+                r.reference[a] = reference[a];
+            invariants.push_back(r);
+        }
+    }
+
+    int status = 0;
+    if (!options.comparePath.empty()) {
+        json_error_t error;
+        json_t* previousJ = json_load_file(options.comparePath.c_str(), 0, &error);
+        if (!previousJ) {
+            fprintf(stderr, "Could not read %s: %s\n", options.comparePath.c_str(), error.text);
+            return 1;
+        }
+        compare(invariants, previousJ, options.tolerance);
+        json_decref(previousJ);
+    }
+
+    printf("\nLong horizon, %d s at %g Hz, HF range, Rate at half, knobs at default, reference in brackets\n", LONG_HORIZON - LONG_SETTLE, SAMPLE_RATE);
+    printf("%-16s %-14s %-4s %20s %20s %20s %20s %22s %s\n", "model", "integrator", "axis", "min", "max", "mean", "rms", "centroid Hz", "");
+    for (const InvariantResult& r : invariants) {
+        for (int a = 0; a < 3; a++) {
+            const Statistics& s = r.axes[a];
+            const Statistics& ref = r.reference[a];
+            printf("%-16s %-14s %-4s %8.3f (%8.3f) %8.3f (%8.3f) %8.3f (%8.3f) %8.3f (%8.3f) %9.1f (%9.1f) %s\n", r.model.c_str(), r.integrator.c_str(), AXIS_NAMES[a],
+                s.min, ref.min, s.max, ref.max, s.mean, ref.mean, s.rms, ref.rms, s.centroid, ref.centroid,
+                (a == 0 && r.compared) ? (r.pass ? "pass" : "FAIL") : "");
+        }
+        if (r.compared && !r.pass)
+            status = 1;
+    }
+
+    if (!options.jsonPath.empty())
+        writeJson(errors, precision, invariants, options.jsonPath);
+    if (!options.csvPath.empty())
+        writeCsv(errors, precision, invariants, options.csvPath);
+    return status;
+}
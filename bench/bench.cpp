@@ -0,0 +1,334 @@
+// Headless benchmark of the modules' process(), outside of Rack.
+// Build and run with `make bench`, see the Makefile for the options.
+#include "bench.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <pmmintrin.h>
+
+
+static const int CV_TABLE_LEN = 4096;
+
+
+struct Result {
+    std::string model;
+    std::string range;
+    std::string quality;
+    std::string integrator;
+    std::string isa;
+    bool record;
+    int channels;
+    float sampleRate;
+    double nsPerSample;
+    double samplesPerSec;
+    double cpu;         // percent of one core at this sample rate
+};
+
+
+/** Synthetic inputs: slow sines on Rate and P1 to P3 CV, different per channel,
+and a 2 Hz reset pulse train. Precomputed, one row per sample, so that the
+loop only copies voltages. They are written as float_4: in Rack the cables are
+stepped long before the module reads them, written one float at a time right
+before process() they would add a store forwarding stall per input.
+*/
+struct Stimulus {
+    float cv[CV_TABLE_LEN][4][16];
+    int resetPeriod;
+    int resetPhase = 0;
+
+    Stimulus(float sampleRate) {
+        for (int i = 0; i < CV_TABLE_LEN; i++)
+            for (int p = 0; p < 4; p++)
+                for (int c = 0; c < 16; c++)
+                    cv[i][p][c] = 2.f * std::sin(2.f * M_PI * (i * (p + 1) / (float) CV_TABLE_LEN + c / 16.f));
+        resetPeriod = (int) (sampleRate / 2.f);
+    }
+
+    void apply(Module* m, int64_t frame, int channels) {
+        int i = frame & (CV_TABLE_LEN - 1);
+        for (int p = 0; p < 4; p++)
+            for (int c = 0; c < channels; c += 4)
+                m->inputs[Ids::INRATE_INPUT + p].setVoltageSimd(simd::float_4::load(&cv[i][p][c]), c);
+        if (++resetPhase >= resetPeriod)
+            resetPhase = 0;
+        float reset = resetPhase < 10 ? 10.f : 0.f;
+        for (int c = 0; c < channels; c += 4)
+            m->inputs[Ids::INRESET_INPUT].setVoltageSimd(simd::float_4(reset), c);
+    }
+};
+
+
+static Module* createModule(Model* model, bool lf, int quality, int integrator, int channels) {
+    Module* m = model->createModule();
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "quality", json_integer(quality));
+    json_object_set_new(rootJ, "integrator", json_integer(integrator));
+    // One node per channel on the cluster
+    json_object_set_new(rootJ, "nodes", json_integer(channels));
+    m->dataFromJson(rootJ);
+    json_decref(rootJ);
+
+    m->params[Ids::RATE_PARAM].setValue(0.7f);
+    m->params[Ids::CVRATE_PARAM].setValue(0.3f);
+    for (int p = 0; p < 3; p++)
+        m->params[Ids::CVP1_PARAM + p].setValue(0.2f);
+    m->params[Ids::RANGE_PARAM].setValue(lf ? 1.f : 0.f);
+    for (int i = 0; i < Ids::INPUTS_LEN; i++)
+        m->inputs[i].channels = channels;
+    for (int i = 0; i < Ids::OUTPUTS_LEN; i++)
+        m->outputs[i].channels = 1;
+    return m;
+}
+
+
+static Result run(Model* model, bool lf, int integrator, int channels, float sampleRate, bool record, Stimulus& stimulus, const Options& options) {
+    Module* m = createModule(model, lf, options.quality, integrator, channels);
+    Module::ProcessArgs args;
+    args.sampleRate = sampleRate;
+    args.sampleTime = 1.f / sampleRate;
+    args.frame = 0;
+
+    int64_t samples = (int64_t) (options.seconds * sampleRate);
+    // Warm up, and let the adaptive and control rate state settle
+    for (int64_t i = 0; i < samples / 10; i++, args.frame++) {
+        stimulus.apply(m, args.frame, channels);
+        m->process(args);
+    }
+
+    // The writer thread runs along with the timed loops
+    Recordable* recordable = dynamic_cast<Recordable*>(m);
+    if (record && recordable && !recordable->recorder.start(options.recordPath, recordable->recordHeader()))
+        fprintf(stderr, "Could not write %s\n", options.recordPath.c_str());
+
+    double best = 1e30;
+    for (int r = 0; r < options.repeats; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int64_t i = 0; i < samples; i++, args.frame++) {
+            stimulus.apply(m, args.frame, channels);
+            m->process(args);
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / samples);
+    }
+    if (recordable && recordable->recorder.dropped)
+        fprintf(stderr, "%llu frames dropped while recording\n", (unsigned long long) recordable->recorder.dropped);
+    delete m;
+
+    Result result;
+    result.model = model->slug;
+    result.range = lf ? "LF" : "HF";
+    result.quality = QUALITY_NAMES[options.quality];
+    // Auto picks its own integrator
+    result.integrator = (options.quality == Ids::QUALITY_AUTO) ? "auto" : INTEGRATOR_NAMES[integrator];
+    result.isa = wideKernels->name;
+    result.record = record;
+    result.channels = channels;
+    result.sampleRate = sampleRate;
+    result.nsPerSample = best;
+    result.samplesPerSec = 1e9 / best;
+    result.cpu = 100.0 * sampleRate / result.samplesPerSec;
+    return result;
+}
+
+
+static void writeJson(const std::vector<Result>& results, const std::string& path) {
+    json_t* rootJ = json_array();
+    for (const Result& r : results) {
+        json_t* resultJ = json_object();
+        json_object_set_new(resultJ, "model", json_string(r.model.c_str()));
+        json_object_set_new(resultJ, "range", json_string(r.range.c_str()));
+        json_object_set_new(resultJ, "quality", json_string(r.quality.c_str()));
+        json_object_set_new(resultJ, "integrator", json_string(r.integrator.c_str()));
+        json_object_set_new(resultJ, "isa", json_string(r.isa.c_str()));
+        json_object_set_new(resultJ, "record", json_boolean(r.record));
+        json_object_set_new(resultJ, "channels", json_integer(r.channels));
+        json_object_set_new(resultJ, "sampleRate", json_real(r.sampleRate));
+        json_object_set_new(resultJ, "nsPerSample", json_real(r.nsPerSample));
+        json_object_set_new(resultJ, "samplesPerSec", json_real(r.samplesPerSec));
+        json_object_set_new(resultJ, "cpu", json_real(r.cpu));
+        json_array_append_new(rootJ, resultJ);
+    }
+    if (json_dump_file(rootJ, path.c_str(), JSON_INDENT(2)) < 0)
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+    json_decref(rootJ);
+}
+
+
+static void writeCsv(const std::vector<Result>& results, const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return;
+    }
+    fprintf(f, "model,range,quality,integrator,isa,record,channels,sampleRate,nsPerSample,samplesPerSec,cpu\n");
+    for (const Result& r : results)
+        fprintf(f, "%s,%s,%s,%s,%s,%d,%d,%g,%.2f,%.0f,%.4f\n", r.model.c_str(), r.range.c_str(), r.quality.c_str(), r.integrator.c_str(), r.isa.c_str(), r.record, r.channels, r.sampleRate, r.nsPerSample, r.samplesPerSec, r.cpu);
+    std::fclose(f);
+}
+
+
+template <typename T>
+static std::vector<T> parseList(const char* s) {
+    std::vector<T> list;
+    const char* p = s;
+    while (*p) {
+        char* end;
+        double value = std::strtod(p, &end);
+        if (end == p)
+            break;
+        list.push_back((T) value);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return list;
+}
+
+
+static std::vector<std::string> parseNames(const char* s) {
+    std::vector<std::string> list;
+    std::string name;
+    for (const char* p = s; ; p++) {
+        if (*p == ',' || !*p) {
+            if (!name.empty())
+                list.push_back(name);
+            name.clear();
+            if (!*p)
+                break;
+        }
+        else {
+            name += *p;
+        }
+    }
+    return list;
+}
+
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: benchmark [options]\n"
+        "  --seconds S          audio rendered per measure, default 0.5\n"
+        "  --repeats N          measures per case, the best one is kept, default 3\n"
+        "  --sample-rates LIST  comma separated, default 44100,48000,96000,192000\n"
+        "  --channels LIST      comma separated, default 1,4,8,16\n"
+        "  --model SLUG         only this module\n"
+        "  --quality NAME       eco, normal, high or auto, default normal\n"
+        "  --isa LIST           wide kernels to compare, comma separated among SSE, AVX2 and\n"
+        "                       AVX-512, default the widest the CPU runs\n"
+        "  --record FILE        time each case again while recording the trajectory into FILE\n"
+        "  --json FILE          write the results as JSON\n"
+        "  --csv FILE           write the results as CSV\n"
+        "  --accuracy           instead of timing, report the error against a double precision\n"
+        "                       reference and the statistical invariants of the outputs\n"
+        "  --compare FILE       with --accuracy, fail if the invariants moved from the ones in\n"
+        "                       this JSON file of a previous run by more than the tolerance\n"
+        "  --tolerance T        relative tolerance of --compare, default 0.15\n"
+        "  --kernels            instead of timing the modules, time one block of Chua in mono\n"
+        "                       through the plain, folded and packed Euler kernels\n");
+}
+
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--accuracy") {
+            options.accuracy = true;
+            continue;
+        }
+        if (arg == "--kernels") {
+            options.kernels = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--seconds")
+            options.seconds = std::atof(value);
+        else if (arg == "--repeats")
+            options.repeats = std::max(1, std::atoi(value));
+        else if (arg == "--sample-rates")
+            options.sampleRates = parseList<float>(value);
+        else if (arg == "--channels")
+            options.channels = parseList<int>(value);
+        else if (arg == "--model")
+            options.model = value;
+        else if (arg == "--isa")
+            options.isas = parseNames(value);
+        else if (arg == "--record")
+            options.recordPath = value;
+        else if (arg == "--quality") {
+            int q = 0;
+            while (q < Ids::QUALITIES_LEN && std::string(QUALITY_NAMES[q]) != value)
+                q++;
+            if (q == Ids::QUALITIES_LEN) {
+                usage();
+                return 1;
+            }
+            options.quality = q;
+        }
+        else if (arg == "--json")
+            options.jsonPath = value;
+        else if (arg == "--csv")
+            options.csvPath = value;
+        else if (arg == "--compare")
+            options.comparePath = value;
+        else if (arg == "--tolerance")
+            options.tolerance = std::atof(value);
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    // Flush denormals to zero, as Rack does in its engine threads
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+
+    Plugin* p = new Plugin;
+    init(p);
+
+    if (options.accuracy)
+        return accuracy(p, options);
+    if (options.kernels)
+        return kernels(options);
+
+    std::vector<std::string> isas = options.isas;
+    if (isas.empty())
+        isas.push_back(wideKernels->name);
+
+    std::vector<Result> results;
+    printf("Quality %s\n", QUALITY_NAMES[options.quality]);
+    std::vector<bool> records = {false};
+    if (!options.recordPath.empty())
+        records.push_back(true);
+
+    printf("%-16s %-5s %-14s %-8s %-6s %8s %8s %12s %14s %8s\n", "model", "range", "integrator", "isa", "record", "channels", "rate", "ns/sample", "samples/sec", "cpu %");
+    for (const std::string& isa : isas) {
+        if (!selectWideKernels(isa)) {
+            printf("Skipping %s, not in this build or not run by this CPU\n", isa.c_str());
+            continue;
+        }
+        for (float sampleRate : options.sampleRates) {
+            Stimulus* stimulus = new Stimulus(sampleRate);
+            for (Model* model : p->models) {
+                if (!options.model.empty() && model->slug != options.model)
+                    continue;
+                for (int lf = 0; lf < 2; lf++)
+                    for (int integrator = 0; integrator < (options.quality == Ids::QUALITY_AUTO ? 1 : Ids::INTEGRATORS_LEN); integrator++)
+                        for (int channels : options.channels)
+                            for (bool record : records) {
+                                Result r = run(model, lf, integrator, clamp(channels, 1, 16), sampleRate, record, *stimulus, options);
+                                printf("%-16s %-5s %-14s %-8s %-6s %8d %8g %12.1f %14.0f %8.3f\n", r.model.c_str(), r.range.c_str(), r.integrator.c_str(), r.isa.c_str(), r.record ? "yes" : "no", r.channels, r.sampleRate, r.nsPerSample, r.samplesPerSec, r.cpu);
+                                fflush(stdout);
+                                results.push_back(r);
+                            }
+            }
+            delete stimulus;
+        }
+    }
+
+    if (!options.jsonPath.empty())
+        writeJson(results, options.jsonPath);
+    if (!options.csvPath.empty())
+        writeCsv(results, options.csvPath);
+    return 0;
+}
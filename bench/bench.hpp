@@ -0,0 +1,43 @@
+#pragma once
+#include "plugin.hpp"
+#include "ChaosModule.hpp"
+#include <cstdio>
+#include <vector>
+
+
+// Parameter and port ids are the same for the three oscillators
+typedef ChaosModule<Chua> Ids;
+
+static const char* const INTEGRATOR_NAMES[] = {"euler", "heun", "rk4", "semi-implicit"};
+static const char* const QUALITY_NAMES[] = {"eco", "normal", "high", "auto"};
+
+
+struct Options {
+    float seconds = 0.5f;
+    int repeats = 3;
+    std::vector<float> sampleRates = {44100.f, 48000.f, 96000.f, 192000.f};
+    std::vector<int> channels = {1, 4, 8, 16};
+    // Wide kernel sets, see Kernels.hpp, empty for the one init() picks
+    std::vector<std::string> isas;
+    // Each case also timed while recording into this file, see Recorder.hpp
+    std::string recordPath;
+    std::string model;
+    int quality = Ids::QUALITY_NORMAL;
+    std::string jsonPath;
+    std::string csvPath;
+    // Accuracy report
+    bool accuracy = false;
+    std::string comparePath;
+    float tolerance = 0.15f;
+    // Kernels of the plain path compared
+    bool kernels = false;
+};
+
+
+/** Error against a double precision reference and statistical invariants, see accuracy.cpp.
+Returns the process exit status, 1 if the invariants moved beyond the tolerance from the compared results.
+*/
+int accuracy(Plugin* p, const Options& options);
+
+/** Time per sample of the kernels the plain path could use for one block, see kernels.cpp */
+int kernels(const Options& options);
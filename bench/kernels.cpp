@@ -0,0 +1,123 @@
+// Kernels for one block of voices, the mono case: Euler of Chua at full HF Rate, SUBSTEPS_HF
+// substeps per sample, then the divergence test and the DC blocker, timed through
+//   plain      Attractor<Chua, EulerIntegrator>, 4 voices in the lanes of float_4
+//   folded     FoldedEuler<Chua>, the plain path of the modules, see Folded.hpp
+//   packed     one voice packed as (x, y, z, 0) in a float_4, shuffled into place for each
+//              component of the derivative
+// The packed kernel is kept here only to compare, the modules do not use it: a single voice
+// is bound by the latency of the chain of operations of each substep, which the shuffles make
+// longer, and it ends up slower than the plain kernel.
+#include "bench.hpp"
+#include "Folded.hpp"
+#include <chrono>
+
+
+static const int KERNEL_SUBSTEPS = Chua::SUBSTEPS_HF;
+static const int KERNEL_SAMPLES = 1 << 20;
+
+
+template <int A, int B, int C, int D>
+static inline simd::float_4 shuffle(simd::float_4 v) {
+    return simd::float_4(_mm_shuffle_ps(v.v, v.v, _MM_SHUFFLE(D, C, B, A)));
+}
+
+/** Chua with the state packed in the lanes of one float_4 */
+struct PackedChua {
+    typedef simd::float_4 float_4;
+    float_4 c;          // C1, C2, -C3, 0
+    float_4 m1;
+    float_4 dm;         // (m0 - m1) / 2
+    float_4 first;      // mask of the first lane
+    float_4 xy;         // mask of the first two lanes
+
+    PackedChua(const float* k) {
+        c = float_4(k[Chua::C1], k[Chua::C2], -k[Chua::C3], 0.f);
+        m1 = k[Chua::M1];
+        dm = 0.5f * (k[Chua::M0] - k[Chua::M1]);
+        first = float_4::cast(simd::int32_4(-1, 0, 0, 0));
+        xy = float_4::cast(simd::int32_4(-1, -1, 0, 0));
+    }
+
+    float_4 derive(float_4 s) const {
+        float_4 x = shuffle<0, 0, 0, 0>(s);
+        float_4 h = x * m1 + dm * (simd::abs(x + 1.f) - simd::abs(x - 1.f));
+        // (y - x - h, x - y + z, y, 0) times c
+        return c * (shuffle<1, 0, 1, 3>(s) - (s & xy) + shuffle<3, 2, 3, 3>(s) - (h & first));
+    }
+};
+
+
+template <typename F>
+static double measure(const Options& options, F f) {
+    double best = 1e30;
+    for (int r = 0; r < options.repeats; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / KERNEL_SAMPLES;
+        best = std::min(best, ns);
+    }
+    return best;
+}
+
+
+int kernels(const Options& options) {
+    typedef simd::float_4 float_4;
+    typedef Attractor<Chua, EulerIntegrator> Solver;
+    float k[Chua::NUM_COEFFS];
+    float_4 k4[Chua::NUM_COEFFS];
+    for (int i = 0; i < Chua::NUM_COEFFS; i++) {
+        const ParamMap m = Chua::paramMap(i);
+        k[i] = clamp(0.5f * m.scale + m.offset, m.min, m.max);
+        k4[i] = k[i];
+    }
+    const float h = Chua::RATE_HF / 48000.f;
+    float sink = 0.f;
+
+    AttractorState<float_4> plain;
+    Solver::init(plain);
+    double plainNs = measure(options, [&]() {
+        for (int i = 0; i < KERNEL_SAMPLES; i++)
+            Solver::process(plain, k4, float_4(h), KERNEL_SUBSTEPS, float_4::zero());
+    });
+    sink += plain.postDC.x[0];
+
+    AttractorState<float_4> folded;
+    Solver::init(folded);
+    const FoldedEuler<Chua> euler(k4, float_4(h));
+    double foldedNs = measure(options, [&]() {
+        for (int i = 0; i < KERNEL_SAMPLES; i++) {
+            for (int j = 0; j < KERNEL_SUBSTEPS; j++)
+                euler.step(folded.s);
+            Solver::finish(folded, float_4::zero());
+        }
+    });
+    sink += folded.postDC.x[0];
+
+    const PackedChua packed(k);
+    const Vec3<float> s0 = Chua::initial<float>();
+    const Vec3<float> c = Chua::clipScale();
+    const float_4 initial(s0.x, s0.y, s0.z, 0.f);
+    const float_4 clipScale(c.x, c.y, c.z, 0.f);
+    float_4 s = initial, preDC = 0.f, postDC = 0.f;
+    double packedNs = measure(options, [&]() {
+        for (int i = 0; i < KERNEL_SAMPLES; i++) {
+            for (int j = 0; j < KERNEL_SUBSTEPS; j++)
+                s = s + h * packed.derive(s);
+            if (simd::movemask(simd::abs(s * clipScale) > 12.f))
+                s = initial;
+            postDC = s - preDC + 0.9999f * postDC;
+            preDC = s;
+        }
+    });
+    sink += postDC[0];
+
+    printf("Chua, Euler, %d substeps per sample, one block\n", KERNEL_SUBSTEPS);
+    printf("%-10s %12s\n", "kernel", "ns/sample");
+    printf("%-10s %12.1f\n", "plain", plainNs);
+    printf("%-10s %12.1f\n", "folded", foldedNs);
+    printf("%-10s %12.1f\n", "packed", packedNs);
+    // Keeps the loops from being optimized away
+    if (sink == 12345.f)
+        printf(" ");
+    return 0;
+}
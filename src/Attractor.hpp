@@ -0,0 +1,258 @@
+#pragma once
+#include "plugin.hpp"
+#include "Decimator.hpp"
+#include "Profile.hpp"
+
+
+/** Point or derivative of a 3-dimensional system */
+template <typename T>
+struct Vec3 {
+    T x;
+    T y;
+    T z;
+};
+
+template <typename T>
+inline Vec3<T> madd(const Vec3<T>& s, T h, const Vec3<T>& d) {
+    return Vec3<T>{s.x + h * d.x, s.y + h * d.y, s.z + h * d.z};
+}
+
+/** Lane types by number of voices processed together */
+template <int Lanes>
+struct LaneType;
+
+template <>
+struct LaneType<1> {
+    typedef float type;
+    typedef bool mask;
+};
+
+template <>
+struct LaneType<4> {
+    typedef simd::float_4 type;
+    typedef simd::float_4 mask;
+};
+
+inline float select(bool mask, float a, float b) {
+    return mask ? a : b;
+}
+
+inline simd::float_4 select(simd::float_4 mask, simd::float_4 a, simd::float_4 b) {
+    return simd::ifelse(mask, a, b);
+}
+
+template <typename T, typename M>
+inline Vec3<T> select(M mask, const Vec3<T>& a, const Vec3<T>& b) {
+    return Vec3<T>{select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z)};
+}
+
+inline float hmax(float a) {
+    return a;
+}
+
+inline float hmax(simd::float_4 a) {
+    return std::max(std::max(a[0], a[1]), std::max(a[2], a[3]));
+}
+
+/** Maps a panel parameter and its CV to one of the ecuation constants.
+coefficient = clamp(knob * scale + offset + V * attenuverter * cv, min, max)
+*/
+struct ParamMap {
+    int param;      // 0 a 2 for P1 a P3
+    float scale;
+    float offset;
+    float cv;
+    float min;
+    float max;
+};
+
+/** State of a group of voices, solution and DC blockers */
+template <typename T>
+struct AttractorState {
+    Vec3<T> s;
+    Vec3<T> preDC;
+    Vec3<T> postDC;
+};
+
+// Integrators
+// EVALS is the number of derivative evaluations per step.
+// ADAPT_CHANGE is the relative change of the derivative allowed within one adaptive substep,
+// tuned against a double precision reference so that each integrator is at least as
+// accurate as the fixed 6 Euler steps at full HF Rate.
+
+struct EulerIntegrator {
+    static constexpr int ORDER = 1;
+    static constexpr int EVALS = 1;
+    static constexpr float ADAPT_CHANGE = 0.12f;
+
+    template <class System, typename T>
+    static void step(Vec3<T>& s, const T* k, T h) {
+        s = madd(s, h, System::derive(s, k));
+    }
+};
+
+/** Explicit trapezoidal rule, Euler predictor and corrector */
+struct HeunIntegrator {
+    static constexpr int ORDER = 2;
+    static constexpr int EVALS = 2;
+    static constexpr float ADAPT_CHANGE = 0.35f;
+
+    template <class System, typename T>
+    static void step(Vec3<T>& s, const T* k, T h) {
+        Vec3<T> d1 = System::derive(s, k);
+        Vec3<T> d2 = System::derive(madd(s, h, d1), k);
+        T h2 = h * 0.5f;
+        s.x = s.x + h2 * (d1.x + d2.x);
+        s.y = s.y + h2 * (d1.y + d2.y);
+        s.z = s.z + h2 * (d1.z + d2.z);
+    }
+};
+
+struct RK4Integrator {
+    static constexpr int ORDER = 4;
+    static constexpr int EVALS = 4;
+    static constexpr float ADAPT_CHANGE = 0.7f;
+
+    template <class System, typename T>
+    static void step(Vec3<T>& s, const T* k, T h) {
+        T h2 = h * 0.5f;
+        T h6 = h * (1.f / 6.f);
+        Vec3<T> d1 = System::derive(s, k);
+        Vec3<T> d2 = System::derive(madd(s, h2, d1), k);
+        Vec3<T> d3 = System::derive(madd(s, h2, d2), k);
+        Vec3<T> d4 = System::derive(madd(s, h, d3), k);
+        s.x = s.x + h6 * (d1.x + 2.f * (d2.x + d3.x) + d4.x);
+        s.y = s.y + h6 * (d1.y + 2.f * (d2.y + d3.y) + d4.y);
+        s.z = s.z + h6 * (d1.z + 2.f * (d2.z + d3.z) + d4.z);
+    }
+};
+
+/** Euler updating one component at a time with the ones already updated (Gauss-Seidel).
+Much more stable than Euler on the rotating part of the attractors. Each component needs the
+derivative at a different state, 3 evaluations per step: once inlined the built-in systems
+only compute the component kept, but the Custom Attractor runs its program whole each time.
+*/
+struct SemiImplicitIntegrator {
+    static constexpr int ORDER = 1;
+    static constexpr int EVALS = 3;
+    static constexpr float ADAPT_CHANGE = 0.2f;
+
+    template <class System, typename T>
+    static void step(Vec3<T>& s, const T* k, T h) {
+        s.x = s.x + h * System::derive(s, k).x;
+        s.y = s.y + h * System::derive(s, k).y;
+        s.z = s.z + h * System::derive(s, k).z;
+    }
+};
+
+static const int MAX_SUBSTEPS = 32;
+
+/** Solver for `System` using `Integrator`, stepping `Lanes` voices at once.
+
+A System supplies, as static members:
+    NUM_COEFFS                  number of ecuation constants
+    paramMap(i)                 constexpr ParamMap of constant i
+    stabilityMap()              cells of the P1-P3 knobs leading to divergence, see StabilityMap.hpp, or null
+    derive(s, k)                derivative at s with constants k
+    warmStates(lf)              WARM_STATES states on the attractor to start from, see WarmStates.hpp, or null
+    initial<T>()                initial conditions, used on reset when there are no warm states
+    clipScale()                 per-axis scale of the ±12 divergence test
+    output(dc)                  output voltages from the DC-blocked state
+    RATE_HF, RATE_LF            rateScale of each range
+    SUBSTEPS_HF                 Euler steps per sample in HF range
+    PERIOD                      mean period in time of the system, for the 1V/oct Rate
+*/
+template <class System, class Integrator, int Lanes = 4>
+struct Attractor {
+    typedef typename LaneType<Lanes>::type T;
+    typedef typename LaneType<Lanes>::mask M;
+
+    static void integrate(Vec3<T>& s, const T* k, T h, int substeps) {
+        for (int i = 0; i < substeps; i++)
+            Integrator::template step<System>(s, k, h);
+    }
+
+    static M clip(const Vec3<T>& s) {
+        using namespace simd;
+        const Vec3<float> c = System::clipScale();
+        return (abs(s.x * c.x) > 12.f) | (abs(s.y * c.y) > 12.f) | (abs(s.z * c.z) > 12.f);
+    }
+
+    static void reset(Vec3<T>& s, M mask) {
+        const Vec3<T> s0 = System::template initial<T>();
+        s.x = select(mask, s0.x, s.x);
+        s.y = select(mask, s0.y, s.y);
+        s.z = select(mask, s0.z, s.z);
+    }
+
+    static void dcBlock(AttractorState<T>& st, const Vec3<T>& in) {
+        PROFILE_SECTION(SECTION_OUTPUT);
+        st.postDC.x = in.x - st.preDC.x + 0.9999f * st.postDC.x;
+        st.preDC.x = in.x;
+        st.postDC.y = in.y - st.preDC.y + 0.9999f * st.postDC.y;
+        st.preDC.y = in.y;
+        st.postDC.z = in.z - st.preDC.z + 0.9999f * st.postDC.z;
+        st.preDC.z = in.z;
+    }
+
+    /** One output sample: integration, reset on trigger or divergence, DC blocker.
+    Returns the lanes that were reset.
+    */
+    static M process(AttractorState<T>& st, const T* k, T h, int substeps, M resetMask) {
+        integrate(st.s, k, h, substeps);
+        return finish(st, resetMask);
+    }
+
+    /** The rest of process() after the integration, for voices integrated by the wide
+    kernels of Kernels.hpp
+    */
+    static M finish(AttractorState<T>& st, M resetMask) {
+        M mask = clip(st.s) | resetMask;
+        reset(st.s, mask);
+        dcBlock(st, st.s);
+        return mask;
+    }
+
+    /** One output sample from `factor` samples at `factor` times the sample rate, each one
+    with `substeps` steps of h. Every sample is kept and goes through the decimators, one per
+    axis, before the DC blocker. Divergence is checked on every sample, the reset trigger
+    on the last one. Returns the lanes that were reset.
+    */
+    static M processOversampled(AttractorState<T>& st, Decimator<T>* dec, int factor, const T* k, T h, int substeps, M resetMask) {
+        T x[8], y[8], z[8];
+        M mask = M();
+        for (int i = 0; i < factor; i++) {
+            integrate(st.s, k, h, substeps);
+            M m = clip(st.s);
+            if (i == factor - 1)
+                m = m | resetMask;
+            reset(st.s, m);
+            mask = mask | m;
+            x[i] = st.s.x;
+            y[i] = st.s.y;
+            z[i] = st.s.z;
+        }
+        Vec3<T> out{dec[0].process(x, factor), dec[1].process(y, factor), dec[2].process(z, factor)};
+        dcBlock(st, out);
+        return mask;
+    }
+
+    /** Substeps needed over one sample going from s0 to s1, from how much the derivative
+    turned on the way, relative to its size. Cheap enough to run every few samples.
+    `quality` multiplies the substeps, 2 allowing half the change per substep.
+    */
+    static int adaptiveSubsteps(const Vec3<T>& s0, const Vec3<T>& s1, const T* k, float quality = 1.f) {
+        using namespace simd;
+        Vec3<T> d0 = System::derive(s0, k);
+        Vec3<T> d1 = System::derive(s1, k);
+        T change = fmax(fmax(abs(d1.x - d0.x), abs(d1.y - d0.y)), abs(d1.z - d0.z));
+        T size = fmax(fmax(abs(d0.x), abs(d0.y)), abs(d0.z)) + 1e-3f;
+        float n = std::ceil(hmax(change / size) * (quality / Integrator::ADAPT_CHANGE));
+        return clamp((int) n, 1, MAX_SUBSTEPS);
+    }
+
+    static void init(AttractorState<T>& st) {
+        st.s = System::template initial<T>();
+        st.preDC = st.postDC = Vec3<T>{0.f, 0.f, 0.f};
+    }
+};
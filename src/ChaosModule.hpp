@@ -0,0 +1,1059 @@
+#pragma once
+#include "Systems.hpp"
+#include "CycleCache.hpp"
+#include "Scope.hpp"
+#include "Expander.hpp"
+#include "Precise.hpp"
+#include "LFEngine.hpp"
+#include "Kernels.hpp"
+#include "Recorder.hpp"
+#include "Lyapunov.hpp"
+#include "Folded.hpp"
+
+
+/** Value that moves linearly to a new target over one control period */
+struct LinearRamp {
+    float value = 0.f;
+    float step = 0.f;
+
+    void setTarget(float target, int samples) {
+        step = (target - value) / samples;
+    }
+
+    void jump(float target) {
+        value = target;
+        step = 0.f;
+    }
+
+    float process() {
+        value += step;
+        return value;
+    }
+};
+
+
+/** Module shared by the chaotic oscillators, parametrized by the System it solves */
+template <class System>
+struct ChaosModule : Module, Recordable {
+    typedef simd::float_4 float_4;
+
+    float sr = 0.f;
+    bool range=false;
+    float rateScale = System::RATE_HF;
+    float rate;
+    // Time advanced per sample is rate * oversampling, whatever the substeps actually used
+    unsigned int oversampling = System::SUBSTEPS_HF;
+
+    enum Integrators {
+        INTEGRATOR_EULER,
+        INTEGRATOR_HEUN,
+        INTEGRATOR_RK4,
+        INTEGRATOR_SEMI_IMPLICIT,
+        INTEGRATORS_LEN
+    };
+    int integrator = INTEGRATOR_EULER;
+    // Rate CV added to the knob, or exponential at 1V/oct with the knob as pitch, PERIOD
+    // turning frequencies into time of the system
+    enum RateModes {
+        RATE_LINEAR,
+        RATE_VOCT,
+        RATE_MODES_LEN
+    };
+    int rateMode = RATE_LINEAR;
+
+    // Adaptive mode keeps the time advanced per sample and picks the number of substeps
+    bool adaptive = false;
+    int substeps[4];
+
+    // Quality tiers scale the substeps of the original 48 kHz step size: Eco takes steps
+    // twice as long, High half as long. Auto picks the integrator by the time advanced
+    // per sample, always with adaptive substeps.
+    enum Qualities {
+        QUALITY_ECO,
+        QUALITY_NORMAL,
+        QUALITY_HIGH,
+        QUALITY_AUTO,
+        QUALITIES_LEN
+    };
+    int quality = QUALITY_NORMAL;
+    int fixedSubsteps = System::SUBSTEPS_HF;
+    float qualityScale = 1.f;
+    int activeIntegrator = INTEGRATOR_EULER;
+    bool activeAdaptive = false;
+
+    // Oversampling renders 2, 4 or 8 samples per sample and decimates them,
+    // with the same time advanced per sample
+    enum OversamplingModes {
+        OVERSAMPLING_OFF,
+        OVERSAMPLING_2X,
+        OVERSAMPLING_4X,
+        OVERSAMPLING_8X,
+        OVERSAMPLING_MODES_LEN
+    };
+    int oversamplingMode = OVERSAMPLING_OFF;
+    int factor = 1;
+
+    // Decimated LF engine, solving the LF voices every LF_DECIMATION samples in steps up to
+    // `segmentStep` long, the HF step at 48 kHz of the quality
+    bool lfEngine = false;
+    float segmentStep;
+    LFSegment segments[4];
+
+    // Periodic orbits played from a table instead of integrated. Allocated with the module,
+    // the menu turns the cache on while the audio thread runs.
+    bool cycleCache = false;
+    CycleCache<System::NUM_COEFFS> cycles[4];
+    dsp::RealFFT cycleFFT{CYCLE_TABLE_LEN};
+
+    // First voice for the panel scope
+    ScopeBuffer scope;
+
+    // Expander bus with the module on the left: common reset, its rate, and its outputs
+    // added to the P1-P3 CV. It arrives one sample later, like through cables.
+    bool busReset = false;
+    bool busRate = false;
+    bool busModulation = false;
+    bool busModulated = false;
+    ChaosBus busMessages[2];
+
+    // Knobs and CV landing in a divergent cell of the stability map are moved to the nearest
+    // stable cell at control rate: the knobs in their targets, the CV of each voice through
+    // an offset added to it per sample, from the CV read at that time
+    bool stableRegions = false;
+    bool steerVoices = false;
+    float_4 steerOffset[4][System::NUM_COEFFS];
+
+    // Parameters are evaluated every PARAM_DIVISION samples and ramped in between.
+    // Coefficients of parameters without CV are clamped there, the ones with CV
+    // get their CV added and clamped per sample and per channel.
+    static const int PARAM_DIVISION = 16;
+    bool paramsReady = false;
+    int channels = 1;
+    bool rateConnected = false;
+    bool cvConnected[3] = {};
+    float rateMax;
+    float gainRate;
+    float gain[System::NUM_COEFFS];
+    LinearRamp rateRamp;
+    LinearRamp coeffRamp[System::NUM_COEFFS];
+
+    // State for up to 16 channels, 4 voices per float_4
+    AttractorState<float_4> voices[4];
+    Decimator<float_4> decimators[4][3];
+    // Double precision state of the blocks stepping below PRECISE_STEP in LF, copied back
+    // to `voices` every sample
+    AttractorState<Double4> preciseVoices[4];
+    bool precise[4] = {};
+    // Lanes reset by the divergence test rather than by a trigger, read by the sweep tool
+    int64_t divergences = 0;
+    // Voices start, and start again on reset or divergence, from states on the attractor of
+    // the middle of the knobs with their DC blockers settled, rather than from the initial
+    // conditions through a transient. Channel c takes warm state c % WARM_STATES.
+    bool warmStart = true;
+    bool warmReady = false;
+    int warmRange = -1;     // of the loaded states, 1 for LF
+    Vec3<float_4> warmState[4];
+    Vec3<float_4> warmDC[4];
+    // Chaos meter, see Lyapunov.hpp, only while its output is connected. It holds while a
+    // block plays a cached orbit.
+    LyapunovMeter<System> meters[4];
+    int meterBlocks = 0;
+
+#ifdef CHAOS_PROFILE
+    // Instrumentation, see Profile.hpp
+    bool profiling = false;
+    ProfileCounters profile;
+
+    ProfileCounters* counters() {
+        return profiling ? &profile : nullptr;
+    }
+#endif
+
+    enum ParamId {
+        RATE_PARAM,
+        P1_PARAM,
+        P2_PARAM,
+        P3_PARAM,
+        CVRATE_PARAM,
+        CVP1_PARAM,
+        CVP2_PARAM,
+        CVP3_PARAM,
+        RANGE_PARAM,
+        PARAMS_LEN
+    };
+    enum InputId {
+        INRATE_INPUT,
+        INP1_INPUT,
+        INP2_INPUT,
+        INP3_INPUT,
+        INRESET_INPUT,
+        INPUTS_LEN
+    };
+    enum OutputId {
+        X_OUTPUT,
+        Y_OUTPUT,
+        Z_OUTPUT,
+        LYAP_OUTPUT,
+        OUTPUTS_LEN
+    };
+    enum LightId {
+        RANGE_LIGHT,
+        CHAOS_LIGHT,
+        LIGHTS_LEN
+    };
+
+    dsp::ClockDivider lightDivider;
+    dsp::ClockDivider paramDivider;
+    dsp::ClockDivider adaptDivider;
+    dsp::TSchmittTrigger<float_4> resetTrigger[4];
+
+    ChaosModule() {
+        config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        configParam(RATE_PARAM, 0.f, 1.f, 0.f, "Rate");
+        configParam(P1_PARAM, 0.f, 1.f, 0.5f, System::paramName(0));
+        configParam(P2_PARAM, 0.f, 1.f, 0.5f, System::paramName(1));
+        configParam(P3_PARAM, 0.f, 1.f, 0.5f, System::paramName(2));
+        configParam(CVRATE_PARAM, -1.f, 1.f, 0.f, "Rate CV");
+        configParam(CVP1_PARAM, -1.f, 1.f, 0.f, std::string(System::paramName(0)) + " CV");
+        configParam(CVP2_PARAM, -1.f, 1.f, 0.f, std::string(System::paramName(1)) + " CV");
+        configParam(CVP3_PARAM, -1.f, 1.f, 0.f, std::string(System::paramName(2)) + " CV");
+        configSwitch(RANGE_PARAM, 0.f, 1.f, 0.f, "Fq Range", {"HF", "LF"});
+        configInput(INRATE_INPUT, "Rate");
+        configInput(INP1_INPUT, System::paramName(0));
+        configInput(INP2_INPUT, System::paramName(1));
+        configInput(INP3_INPUT, System::paramName(2));
+        configInput(INRESET_INPUT, "Reset");
+        configOutput(X_OUTPUT, "X");
+        configOutput(Y_OUTPUT, "Y");
+        configOutput(Z_OUTPUT, "Z");
+        configOutput(LYAP_OUTPUT, "Largest Lyapunov exponent, 10V per nat and period");
+        configLight(CHAOS_LIGHT, "Chaos");
+
+        lightDivider.setDivision(16);
+        paramDivider.setDivision(PARAM_DIVISION);
+        adaptDivider.setDivision(16);
+
+        for (int b = 0; b < 4; b++)
+            substeps[b] = System::SUBSTEPS_HF;
+        startVoices();
+
+        leftExpander.producerMessage = &busMessages[0];
+        leftExpander.consumerMessage = &busMessages[1];
+    }
+
+    void process(const ProcessArgs& args) override {
+        PROFILE_SAMPLE(counters());
+        if (!paramsReady || paramDivider.process())
+            processParams(args.sampleRate);
+
+        rate = rateRamp.process();
+        float coeffs[System::NUM_COEFFS];
+        for (int i = 0; i < System::NUM_COEFFS; i++)
+            coeffs[i] = coeffRamp[i].process();
+
+        const ChaosBus* bus = leftBus(this);
+        ChaosBus* next = rightBus(this);
+        switch (activeIntegrator) {
+            default:
+            case INTEGRATOR_EULER: processVoices<EulerIntegrator>(coeffs, bus, next); break;
+            case INTEGRATOR_HEUN: processVoices<HeunIntegrator>(coeffs, bus, next); break;
+            case INTEGRATOR_RK4: processVoices<RK4Integrator>(coeffs, bus, next); break;
+            case INTEGRATOR_SEMI_IMPLICIT: processVoices<SemiImplicitIntegrator>(coeffs, bus, next); break;
+        }
+        recorder.push([&](int b) {
+            return voices[b].preDC;
+        });
+        if (next) {
+            next->channels = channels;
+            rightExpander.module->leftExpander.requestMessageFlip();
+        }
+        outputs[X_OUTPUT].setChannels(channels);
+        outputs[Y_OUTPUT].setChannels(channels);
+        outputs[Z_OUTPUT].setChannels(channels);
+        scope.process(outputs[X_OUTPUT].getVoltage(0), outputs[Y_OUTPUT].getVoltage(0), outputs[Z_OUTPUT].getVoltage(0));
+
+        // Lights
+        if (lightDivider.process()) {
+            lights[RANGE_LIGHT].setBrightness(range);
+            // Full at half a nat per period, the growth of the noise-like states
+            lights[CHAOS_LIGHT].setBrightness(meterBlocks ? clamp(meters[0].voltage()[0] / (0.5f * LYAPUNOV_VOLTS), 0.f, 1.f) : 0.f);
+        }
+    }
+
+    /** Control rate: range, parameter maps, CV gains and polyphony */
+    void processParams(float sampleRate) {
+        // Frequency range
+        range = params[RANGE_PARAM].getValue() > 0.f;
+        if (range) {
+            oversampling = 1;
+            rateScale = System::RATE_LF;
+        }
+        else {
+            oversampling = System::SUBSTEPS_HF;
+            rateScale = System::RATE_HF;
+        }
+
+        if ((int) range != warmRange)
+            loadWarmStates();
+
+        // Periodic orbit cache, tables are only valid at the sample rate they were captured at
+        for (int b = 0; b < 4; b++) {
+            if (!cycleCache || sampleRate != sr) {
+                if (cycles[b].playing)
+                    resetDecimators(b);
+                cycles[b].clear();
+            }
+        }
+
+        // Quality
+        sr = sampleRate;
+        scope.setRate(sr, range);
+        float stepScale = 48000.f / sr;
+        qualityScale = (quality == QUALITY_ECO) ? 0.5f : (quality == QUALITY_HIGH) ? 2.f : 1.f;
+        fixedSubsteps = std::max(1, (int) std::lround(oversampling * qualityScale * stepScale));
+        segmentStep = System::RATE_HF / 48000.f / qualityScale;
+        activeIntegrator = integrator;
+        activeAdaptive = adaptive;
+        if (quality == QUALITY_AUTO) {
+            float rateKnob = inputs[INRATE_INPUT].isConnected() ? 1.f : knobRate();
+            activeIntegrator = autoIntegrator(rateKnob * rateScale * oversampling / System::RATE_HF / System::SUBSTEPS_HF * stepScale);
+            activeAdaptive = true;
+        }
+
+        // Oversampling, decimators restart from the current state when it changes
+        int newFactor = 1 << oversamplingMode;
+        if (newFactor != factor) {
+            factor = newFactor;
+            resetDecimators();
+        }
+
+        // Polyphony: one voice per channel of the widest input, or of the module on the left
+        // when following it
+        const ChaosBus* bus = leftBus(this);
+        channels = 1;
+        for (int i = 0; i < INPUTS_LEN; i++)
+            channels = std::max(channels, inputs[i].getChannels());
+        if (bus && (busReset || busRate || busModulation))
+            channels = std::max(channels, bus->channels);
+        rateConnected = inputs[INRATE_INPUT].isConnected();
+        for (int p = 0; p < 3; p++)
+            cvConnected[p] = inputs[INP1_INPUT + p].isConnected();
+        busModulated = bus && busModulation;
+
+        // Cycle tables being captured, a stage each
+        if (cycleCache) {
+            for (int b = 0; b < 4; b++)
+                cycles[b].update(cycleFFT, (factor > 1) ? Decimator<float>::latency(factor) : 0.f);
+        }
+
+        // Chaos meter
+        meterBlocks = outputs[LYAP_OUTPUT].isConnected() ? (channels + 3) / 4 : 0;
+        outputs[LYAP_OUTPUT].setChannels(channels);
+        for (int b = 0; b < meterBlocks; b++) {
+            meters[b].update();
+            outputs[LYAP_OUTPUT].setVoltageSimd(meters[b].voltage(), 4 * b);
+        }
+
+        // Parameters
+        rateMax = rateScale / sr;
+        float rateTarget = knobRate() * rateMax;
+        if (rateMode == RATE_VOCT)
+            gainRate = params[CVRATE_PARAM].getValue();
+        else
+            gainRate = params[CVRATE_PARAM].getValue() * rateScale * 0.037f / sr;
+        float knobs[3];
+        for (int p = 0; p < 3; p++)
+            knobs[p] = params[P1_PARAM + p].getValue();
+        const uint16_t* map = stableRegions ? System::stabilityMap() : nullptr;
+        steerVoices = map && (cvConnected[0] || cvConnected[1] || cvConnected[2] || busModulated);
+        if (map && !steerVoices)
+            steer(map, knobs);
+        float coeffTarget[System::NUM_COEFFS];
+        for (int i = 0; i < System::NUM_COEFFS; i++) {
+            const ParamMap m = System::paramMap(i);
+            coeffTarget[i] = knobs[m.param] * m.scale + m.offset;
+            if (!cvConnected[m.param] && !busModulated && !steerVoices)
+                coeffTarget[i] = clamp(coeffTarget[i], m.min, m.max);
+            gain[i] = params[CVP1_PARAM + m.param].getValue() * m.cv;
+        }
+        if (steerVoices)
+            steerCV(map, knobs, bus);
+        else
+            std::memset(steerOffset, 0, sizeof(steerOffset));
+
+        if (!paramsReady) {
+            rateRamp.jump(rateTarget);
+            for (int i = 0; i < System::NUM_COEFFS; i++)
+                coeffRamp[i].jump(coeffTarget[i]);
+            paramsReady = true;
+        }
+        else {
+            rateRamp.setTarget(rateTarget, PARAM_DIVISION);
+            for (int i = 0; i < System::NUM_COEFFS; i++)
+                coeffRamp[i].setTarget(coeffTarget[i], PARAM_DIVISION);
+        }
+    }
+
+    /** Moves knob positions `u` in a divergent cell of `map` just inside the nearest stable one */
+    static void steer(const uint16_t* map, float* u) {
+        const int n = STABILITY_CELLS;
+        int cell[3];
+        for (int p = 0; p < 3; p++)
+            cell[p] = clamp((int) (u[p] * n), 0, n - 1);
+        int i = (cell[0] * n + cell[1]) * n + cell[2];
+        int j = map[i];
+        if (j == i)
+            return;
+        const int target[3] = {j / (n * n), j / n % n, j % n};
+        for (int p = 0; p < 3; p++)
+            u[p] = clamp(u[p], (target[p] + 0.001f) / n, (target[p] + 0.999f) / n);
+    }
+
+    /** Offsets of the coefficients of each voice moving its knobs plus CV, as knob positions,
+    out of divergent cells. The CV of a parameter is turned into knob positions through the
+    gain of its last coefficient, the others differing by a few percent.
+    */
+    void steerCV(const uint16_t* map, const float* knobs, const ChaosBus* bus) {
+        float knobGain[3] = {};
+        for (int i = 0; i < System::NUM_COEFFS; i++) {
+            const ParamMap m = System::paramMap(i);
+            if (m.scale != 0.f)
+                knobGain[m.param] = gain[i] / m.scale;
+        }
+        for (int c = 0; c < channels; c += 4) {
+            int b = c / 4;
+            const ChaosBus* left = (bus && bus->has(c)) ? bus : nullptr;
+            float_4 u[3];
+            for (int p = 0; p < 3; p++) {
+                float_4 cv = 0.f;
+                if (cvConnected[p])
+                    cv = inputs[INP1_INPUT + p].template getPolyVoltageSimd<float_4>(c);
+                if (left && busModulated)
+                    cv += left->get(p == 0 ? left->x : p == 1 ? left->y : left->z, c);
+                u[p] = knobs[p] + cv * knobGain[p];
+            }
+            float_4 du[3];
+            for (int lane = 0; lane < 4; lane++) {
+                float v[3] = {u[0][lane], u[1][lane], u[2][lane]};
+                steer(map, v);
+                for (int p = 0; p < 3; p++)
+                    du[p][lane] = v[p] - u[p][lane];
+            }
+            for (int i = 0; i < System::NUM_COEFFS; i++) {
+                const ParamMap m = System::paramMap(i);
+                steerOffset[b][i] = du[m.param] * m.scale;
+            }
+        }
+    }
+
+    /** Rate of the knob, 0 to 1 of the range. At 1V/oct the knob spans 4 octaves each way
+    from C4 in HF and 2 Hz in LF, up to the top of the range.
+    */
+    float knobRate() {
+        float knob = params[RATE_PARAM].getValue();
+        if (rateMode != RATE_VOCT)
+            return knob;
+        float freq = (range ? 2.f : dsp::FREQ_C4) * std::exp2(8.f * knob - 4.f);
+        return std::min(freq * System::PERIOD / (oversampling * rateScale), 1.f);
+    }
+
+    /** Integrator of the Auto quality, from the time advanced per sample relative to the
+    HF range at full Rate and 48 kHz. Measured with the accuracy report of the benchmark:
+    RK4 with adaptive substeps is the most accurate for its cost at long steps, Heun in
+    between, and at LF the Euler error is already far below what can be heard.
+    */
+    static int autoIntegrator(float relativeTime) {
+        if (relativeTime > 0.3f)
+            return INTEGRATOR_RK4;
+        if (relativeTime > 0.02f)
+            return INTEGRATOR_HEUN;
+        return INTEGRATOR_EULER;
+    }
+
+    static int integratorEvals(int i) {
+        return (i == INTEGRATOR_HEUN) ? HeunIntegrator::EVALS
+            : (i == INTEGRATOR_RK4) ? RK4Integrator::EVALS
+            : (i == INTEGRATOR_SEMI_IMPLICIT) ? SemiImplicitIntegrator::EVALS
+            : EulerIntegrator::EVALS;
+    }
+
+    /** Mean integration steps per sample of the running voices, for the context menu */
+    float stepsPerSample() {
+        int blocks = (channels + 3) / 4;
+        float sum = 0.f;
+        for (int b = 0; b < blocks; b++) {
+            if (isCached(b))
+                continue;
+            if (segments[b].active) {
+                sum += (float) segments[b].substeps / LF_DECIMATION;
+                continue;
+            }
+            int n = activeAdaptive ? substeps[b] : fixedSubsteps;
+            sum += (n + factor - 1) / factor * factor;
+        }
+        return sum / blocks;
+    }
+
+    bool isCached(int b) {
+        return cycleCache && cycles[b].playing;
+    }
+
+    /** Voices of one sample. `bus` is the message from the module on the left and `next`
+    the one for the module on the right, each null when there is none.
+    */
+    template <class Integrator>
+    void processVoices(const float* coeffs, const ChaosBus* bus, ChaosBus* next) {
+        typedef Attractor<System, Integrator> Solver;
+        bool adapt = activeAdaptive && adaptDivider.process();
+        // Blocks of plain integration wait for a single call of the wide kernel of the CPU,
+        // if it has one, see Kernels.hpp
+        WideKernel kernel = (channels > 4) ? voicesKernel<System>(activeIntegrator) : nullptr;
+        WideBlock wide[4];
+        int wideLen = 0;
+
+        for (int c = 0; c < channels; c += 4) {
+            int b = c / 4;
+            const ChaosBus* left = (bus && bus->has(c)) ? bus : nullptr;
+
+            float_4 resetSignal = inputs[INRESET_INPUT].template getPolyVoltageSimd<float_4>(c);
+            float_4 resetBang = resetTrigger[b].process(resetSignal, 0.1f, 2.f);
+            if (left && busReset)
+                resetBang = resetBang | left->get(left->reset, c);
+            PROFILE_COUNT(counters(), voiceSamples, std::min(channels - c, 4));
+            PROFILE_COUNT(counters(), triggerResets, __builtin_popcount(simd::movemask(resetBang) & ((1 << std::min(channels - c, 4)) - 1)));
+
+            // Decimated LF engine within a segment, only following the trajectory. CV is
+            // read when the next segment is solved.
+            LFSegment& seg = segments[b];
+            if (seg.active && !seg.done() && !simd::movemask(resetBang) && lfEngine && range && factor == 1) {
+                Solver::dcBlock(voices[b], seg.process());
+                if (next) {
+                    next->rate[b] = seg.h / rateMax;
+                    next->reset[b] = resetBang;
+                }
+                setOutputs(b, next);
+                continue;
+            }
+
+            // CV, only on connected inputs
+            float_4 h = rate;
+            if (left && busRate) {
+                h = left->get(left->rate, c) * rateMax;
+            }
+            else if (rateConnected) {
+                float_4 CVrate = inputs[INRATE_INPUT].template getPolyVoltageSimd<float_4>(c) * gainRate;
+                if (rateMode == RATE_VOCT)
+                    h = simd::fmin(h * dsp::exp2_taylor5(CVrate), rateMax);
+                else
+                    h = simd::clamp(h + CVrate, 0.f, rateMax);
+            }
+            float_4 cv[3] = {};
+            for (int p = 0; p < 3; p++) {
+                if (cvConnected[p])
+                    cv[p] = inputs[INP1_INPUT + p].template getPolyVoltageSimd<float_4>(c);
+            }
+            if (left && busModulated) {
+                cv[0] += left->get(left->x, c);
+                cv[1] += left->get(left->y, c);
+                cv[2] += left->get(left->z, c);
+            }
+            float_4 k[System::NUM_COEFFS];
+            for (int i = 0; i < System::NUM_COEFFS; i++) {
+                const ParamMap m = System::paramMap(i);
+                k[i] = coeffs[i];
+                if (cvConnected[m.param] || busModulated || steerVoices)
+                    k[i] = simd::clamp(k[i] + cv[m.param] * gain[i] + steerOffset[b][i], m.min, m.max);
+            }
+
+            if (next) {
+                next->rate[b] = h / rateMax;
+                next->reset[b] = resetBang;
+            }
+
+            // Cached periodic orbit, back to integration from the same point on reset
+            // or when it no longer applies
+            int lanes = std::min(channels - c, 4);
+            bool cached = false;
+            if (cycleCache && cycles[b].playing) {
+                if (!simd::movemask(resetBang) && cycles[b].process(voices[b].s, lanes, k, h)) {
+                    Solver::dcBlock(voices[b], voices[b].s);
+                    precise[b] = false;
+                    segments[b].active = false;
+                    cached = true;
+                }
+                else {
+                    cycles[b].clear();
+                    resetDecimators(b);
+                }
+            }
+
+            if (!cached && lfEngine && range && factor == 1) {
+                float_4 resetMask = processSegment<Integrator>(b, k, h, resetBang);
+                countDivergences(resetMask, resetBang, lanes);
+            }
+            else if (!cached) {
+                // Back from the decimated LF engine, which solves ahead of the output
+                if (segments[b].active) {
+                    voices[b].s = segments[b].point;
+                    segments[b].active = false;
+                    precise[b] = false;
+                }
+
+                // Substeps, the time advanced per sample stays h * oversampling,
+                // split evenly between the oversampled samples
+                float_4 hSample = h;
+                int n = activeAdaptive ? substeps[b] : fixedSubsteps;
+                n = (n + factor - 1) / factor;
+                if (n * factor != (int) oversampling)
+                    h *= (float) oversampling / (n * factor);
+                PROFILE_COUNT(counters(), steps, n * factor * lanes);
+
+                // Double precision for the slow LF steps, entering at PRECISE_STEP and
+                // leaving a bit above so that it does not toggle around it
+                bool slow = range && factor == 1 && hmax(h) < (precise[b] ? 1.5f : 1.f) * PRECISE_STEP;
+                if (slow && !precise[b])
+                    loadPrecise(preciseVoices[b], voices[b]);
+                precise[b] = slow;
+
+                // Solution, reset and DC blocker
+                if (kernel && !precise[b] && factor == 1 && (wideLen == 0 || n == wide[0].substeps)) {
+                    WideBlock& w = wide[wideLen++];
+                    w.b = b;
+                    w.resetBang = resetBang;
+                    std::copy(k, k + System::NUM_COEFFS, w.k);
+                    w.h = h;
+                    w.hSample = hSample;
+                    w.substeps = n;
+                    continue;
+                }
+                Vec3<float_4> s0 = voices[b].s;
+                float_4 resetMask;
+                if (precise[b])
+                    resetMask = processPrecise<Integrator>(b, k, h, n, resetBang);
+                else if (factor > 1)
+                    resetMask = Solver::processOversampled(voices[b], decimators[b], factor, k, h, n, resetBang);
+                else if (FoldedEuler<System>::ENABLED && std::is_same<Integrator, EulerIntegrator>::value)
+                    resetMask = processFolded(b, k, h, n, resetBang);
+                else
+                    resetMask = Solver::process(voices[b], k, h, n, resetBang);
+                finishVoices<Integrator>(b, s0, k, hSample, resetMask, resetBang, adapt);
+            }
+
+            setOutputs(b, next);
+        }
+
+        if (wideLen)
+            processWide<Integrator>(kernel, wide, wideLen, adapt, next);
+    }
+
+    /** Block of the plain path waiting for the wide kernel, with what its voices need after
+    the integration
+    */
+    struct WideBlock {
+        int b;
+        float_4 resetBang;
+        float_4 k[System::NUM_COEFFS];
+        float_4 h;
+        float_4 hSample;
+        int substeps;
+    };
+
+    /** Integration of the waiting blocks in one call of `kernel`, their lanes side by side,
+    and the rest of their sample
+    */
+    template <class Integrator>
+    void processWide(WideKernel kernel, WideBlock* wide, int len, bool adapt, ChaosBus* next) {
+        typedef Attractor<System, Integrator> Solver;
+        Vec3<float_4> s0[4];
+        for (int i = 0; i < len; i++)
+            s0[i] = voices[wide[i].b].s;
+
+        if (len == 1) {
+            Solver::integrate(voices[wide[0].b].s, wide[0].k, wide[0].h, wide[0].substeps);
+        }
+        else {
+            const int lanes = 4 * len;
+            float x[16], y[16], z[16], h[16];
+            float k[System::NUM_COEFFS * 16];
+            for (int i = 0; i < len; i++) {
+                WideBlock& w = wide[i];
+                voices[w.b].s.x.store(x + 4 * i);
+                voices[w.b].s.y.store(y + 4 * i);
+                voices[w.b].s.z.store(z + 4 * i);
+                w.h.store(h + 4 * i);
+                for (int j = 0; j < System::NUM_COEFFS; j++)
+                    w.k[j].store(k + j * lanes + 4 * i);
+            }
+            kernel(x, y, z, k, h, lanes, wide[0].substeps);
+            for (int i = 0; i < len; i++)
+                voices[wide[i].b].s = Vec3<float_4>{float_4::load(x + 4 * i), float_4::load(y + 4 * i), float_4::load(z + 4 * i)};
+        }
+
+        for (int i = 0; i < len; i++) {
+            WideBlock& w = wide[i];
+            float_4 resetMask = Solver::finish(voices[w.b], w.resetBang);
+            finishVoices<Integrator>(w.b, s0[i], w.k, w.hSample, resetMask, w.resetBang, adapt);
+            setOutputs(w.b, next);
+        }
+    }
+
+    /** After the integration of block b from s0 and its reset: divergences, warm start, chaos
+    meter, adaptive substeps and the cycle cache
+    */
+    template <class Integrator>
+    void finishVoices(int b, const Vec3<float_4>& s0, const float_4* k, float_4 hSample, float_4 resetMask, float_4 resetBang, bool adapt) {
+        typedef Attractor<System, Integrator> Solver;
+        int lanes = std::min(channels - 4 * b, 4);
+        countDivergences(resetMask, resetBang, lanes);
+        if (warmStart && warmReady && simd::movemask(resetMask))
+            warmReset(b, resetMask);
+        if (b < meterBlocks)
+            meters[b].record(s0, voices[b].s, k, hSample * (float) oversampling, resetMask);
+        if (adapt && !simd::movemask(resetMask))
+            substeps[b] = Solver::adaptiveSubsteps(s0, voices[b].s, k, qualityScale);
+
+        if (cycleCache) {
+            if (simd::movemask(resetMask))
+                cycles[b].clear();
+            else
+                cycles[b].detect(voices[b].s, lanes, k, hSample);
+        }
+    }
+
+    void countDivergences(float_4 resetMask, float_4 resetBang, int lanes) {
+        int diverged = simd::movemask(resetMask) & ~simd::movemask(resetBang) & ((1 << lanes) - 1);
+        if (diverged) {
+            divergences += __builtin_popcount(diverged);
+            PROFILE_COUNT(counters(), divergenceResets, __builtin_popcount(diverged));
+        }
+    }
+
+    void setOutputs(int b, ChaosBus* next) {
+        PROFILE_SECTION(SECTION_OUTPUT);
+        Vec3<float_4> out = System::output(voices[b].postDC);
+        outputs[X_OUTPUT].setVoltageSimd(out.x, 4 * b);
+        outputs[Y_OUTPUT].setVoltageSimd(out.y, 4 * b);
+        outputs[Z_OUTPUT].setVoltageSimd(out.z, 4 * b);
+        if (next) {
+            next->x[b] = out.x;
+            next->y[b] = out.y;
+            next->z[b] = out.z;
+        }
+    }
+
+    /** One sample of block b in the decimated LF engine, see LFEngine.hpp, solving a new
+    segment when the last one ends or on reset. Returns the lanes that were reset.
+    */
+    template <class Integrator>
+    float_4 processSegment(int b, const float_4* k, float_4 h, float_4 resetBang) {
+        typedef Attractor<System, Integrator> Solver;
+        LFSegment& seg = segments[b];
+        float_4 resetMask = float_4::zero();
+        if (!seg.active || seg.done() || simd::movemask(resetBang)) {
+            // From the end of the last segment, or from where the output is on reset. The
+            // double precision state only carries on from the end of the last segment.
+            bool onward = seg.active && seg.done() && !simd::movemask(resetBang);
+            Vec3<float_4> p0 = seg.active ? seg.point : voices[b].s;
+            Solver::reset(p0, resetBang);
+            bool warm = warmStart && warmReady;
+            if (warm)
+                p0 = select(resetBang, warmState[b], p0);
+
+            float_4 time = h * (float) LF_DECIMATION;
+            int n = clamp((int) std::ceil(hmax(time) / segmentStep), 1, MAX_SUBSTEPS);
+            float_4 hs = time / (float) n;
+            PROFILE_COUNT(counters(), steps, n * std::min(channels - 4 * b, 4));
+            Vec3<float_4> s = p0;
+            if (hmax(hs) < PRECISE_STEP) {
+                if (!onward || !precise[b])
+                    preciseVoices[b].s = toDouble(p0);
+                Double4 kd[System::NUM_COEFFS];
+                for (int i = 0; i < System::NUM_COEFFS; i++)
+                    kd[i] = Double4(k[i]);
+                Attractor<System, Integrator, PRECISE_LANES>::integrate(preciseVoices[b].s, kd, Double4(hs), n);
+                s = toFloat(preciseVoices[b].s);
+                precise[b] = true;
+            }
+            else {
+                Solver::integrate(s, k, hs, n);
+                precise[b] = false;
+            }
+
+            // Diverging lanes start again and hold there until the next segment
+            float_4 clipMask = Solver::clip(s);
+            if (simd::movemask(clipMask)) {
+                Solver::reset(s, clipMask);
+                if (warm)
+                    s = select(clipMask, warmState[b], s);
+                p0 = Vec3<float_4>{select(clipMask, s.x, p0.x), select(clipMask, s.y, p0.y), select(clipMask, s.z, p0.z)};
+                precise[b] = false;
+            }
+            voices[b].s = s;
+            if (b < meterBlocks)
+                meters[b].record(p0, s, k, time, resetBang | clipMask);
+            seg.start(p0, s, System::derive(p0, k), System::derive(s, k), time);
+            seg.h = h;
+            seg.substeps = n;
+            resetMask = resetBang | clipMask;
+            if (warm) {
+                voices[b].preDC = select(resetMask, warmState[b], voices[b].preDC);
+                voices[b].postDC = select(resetMask, warmDC[b], voices[b].postDC);
+            }
+        }
+        Solver::dcBlock(voices[b], seg.process());
+        return resetMask;
+    }
+
+    template <class Integrator>
+    float_4 processPrecise(int b, const float_4* k, float_4 h, int n, float_4 resetBang) {
+        Double4 kd[System::NUM_COEFFS];
+        for (int i = 0; i < System::NUM_COEFFS; i++)
+            kd[i] = Double4(k[i]);
+        float_4 resetMask = Attractor<System, Integrator, PRECISE_LANES>::process(preciseVoices[b], kd, Double4(h), n, resetBang);
+        storePrecise(voices[b], preciseVoices[b]);
+        return resetMask;
+    }
+
+    /** Euler of the plain path, see Folded.hpp */
+    float_4 processFolded(int b, const float_4* k, float_4 h, int n, float_4 resetBang) {
+        const FoldedEuler<System> euler(k, h);
+        for (int i = 0; i < n; i++)
+            euler.step(voices[b].s);
+        return Attractor<System, EulerIntegrator>::finish(voices[b], resetBang);
+    }
+
+    bool isPrecise() {
+        for (int b = 0; b < (channels + 3) / 4; b++) {
+            if (precise[b] && !isCached(b))
+                return true;
+        }
+        return false;
+    }
+
+    void resetDecimators(int b) {
+        decimators[b][0].reset(voices[b].s.x);
+        decimators[b][1].reset(voices[b].s.y);
+        decimators[b][2].reset(voices[b].s.z);
+    }
+
+    void resetDecimators() {
+        for (int b = 0; b < 4; b++)
+            resetDecimators(b);
+    }
+
+    /** WARM_STATES entries as in WarmStates.hpp for a range, or null */
+    virtual const float* warmTable(bool lf) {
+        return System::warmStates(lf);
+    }
+
+    /** Warm states of the range on the panel */
+    void loadWarmStates() {
+        bool lf = params[RANGE_PARAM].getValue() > 0.f;
+        const float* table = warmTable(lf);
+        warmRange = lf;
+        warmReady = table;
+        if (!table)
+            return;
+        for (int c = 0; c < 16; c++) {
+            const float* w = table + 6 * (c % WARM_STATES);
+            Vec3<float_4>& s = warmState[c / 4];
+            Vec3<float_4>& dc = warmDC[c / 4];
+            s.x[c % 4] = w[0];
+            s.y[c % 4] = w[1];
+            s.z[c % 4] = w[2];
+            dc.x[c % 4] = w[3];
+            dc.y[c % 4] = w[4];
+            dc.z[c % 4] = w[5];
+        }
+    }
+
+    /** Lanes of block b in `mask` to their warm states, with settled DC blockers */
+    void warmReset(int b, float_4 mask) {
+        AttractorState<float_4>& st = voices[b];
+        st.s = select(mask, warmState[b], st.s);
+        st.preDC = select(mask, warmState[b], st.preDC);
+        st.postDC = select(mask, warmDC[b], st.postDC);
+        if (precise[b]) {
+            AttractorState<Double4>& pst = preciseVoices[b];
+            pst.s = select(mask, toDouble(st.s), pst.s);
+            pst.preDC = select(mask, toDouble(st.preDC), pst.preDC);
+            pst.postDC = select(mask, toDouble(st.postDC), pst.postDC);
+        }
+        if (factor > 1) {
+            decimators[b][0].reset(st.s.x, mask);
+            decimators[b][1].reset(st.s.y, mask);
+            decimators[b][2].reset(st.s.z, mask);
+        }
+    }
+
+    /** Every voice from the start, from its warm state or from the initial conditions */
+    void startVoices() {
+        loadWarmStates();
+        for (int b = 0; b < 4; b++) {
+            Attractor<System, EulerIntegrator>::init(voices[b]);
+            meters[b].reset();
+            precise[b] = false;
+            segments[b].active = false;
+            if (warmStart && warmReady)
+                warmReset(b, float_4::mask());
+        }
+        for (CycleCache<System::NUM_COEFFS>& cycle : cycles)
+            cycle.clear();
+        resetDecimators();
+    }
+
+    /** Voices from the "state" of dataToJson, the ones missing there from the start */
+    void restoreVoices(json_t* stateJ) {
+        startVoices();
+        int n = std::min((int) json_array_size(stateJ), 16);
+        for (int c = 0; c < n; c++) {
+            json_t* voiceJ = json_array_get(stateJ, c);
+            if (json_array_size(voiceJ) != 9)
+                continue;
+            AttractorState<float_4>& st = voices[c / 4];
+            Vec3<float_4>* v[3] = {&st.s, &st.preDC, &st.postDC};
+            for (int i = 0; i < 3; i++) {
+                v[i]->x[c % 4] = json_number_value(json_array_get(voiceJ, 3 * i));
+                v[i]->y[c % 4] = json_number_value(json_array_get(voiceJ, 3 * i + 1));
+                v[i]->z[c % 4] = json_number_value(json_array_get(voiceJ, 3 * i + 2));
+            }
+        }
+        resetDecimators();
+    }
+
+    RecordHeader recordHeader() override {
+        RecordHeader h;
+        if (model)
+            std::strncpy(h.system, model->slug.c_str(), sizeof(h.system) - 1);
+        h.sampleRate = sr;
+        h.channels = channels;
+        h.integrator = integrator;
+        h.quality = quality;
+        for (int i = 0; i < std::min((int) PARAMS_LEN, RECORD_PARAMS); i++)
+            h.params[i] = params[i].getValue();
+        return h;
+    }
+
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "integrator", json_integer(integrator));
+        json_object_set_new(rootJ, "rateMode", json_integer(rateMode));
+        json_object_set_new(rootJ, "adaptive", json_boolean(adaptive));
+        json_object_set_new(rootJ, "oversampling", json_integer(oversamplingMode));
+        json_object_set_new(rootJ, "quality", json_integer(quality));
+        json_object_set_new(rootJ, "cycleCache", json_boolean(cycleCache));
+        json_object_set_new(rootJ, "lfEngine", json_boolean(lfEngine));
+        json_object_set_new(rootJ, "busReset", json_boolean(busReset));
+        json_object_set_new(rootJ, "busRate", json_boolean(busRate));
+        json_object_set_new(rootJ, "busModulation", json_boolean(busModulation));
+        json_object_set_new(rootJ, "stableRegions", json_boolean(stableRegions));
+        json_object_set_new(rootJ, "warmStart", json_boolean(warmStart));
+        // Solution and DC blockers of each voice, to carry on from there when loaded
+        json_t* stateJ = json_array();
+        for (int c = 0; c < channels; c++) {
+            AttractorState<float_4>& st = voices[c / 4];
+            const Vec3<float_4>* v[3] = {&st.s, &st.preDC, &st.postDC};
+            json_t* voiceJ = json_array();
+            for (int i = 0; i < 3; i++) {
+                const float x[3] = {v[i]->x[c % 4], v[i]->y[c % 4], v[i]->z[c % 4]};
+                for (int j = 0; j < 3; j++)
+                    json_array_append_new(voiceJ, json_real(std::isfinite(x[j]) ? x[j] : 0.0));
+            }
+            json_array_append_new(stateJ, voiceJ);
+        }
+        json_object_set_new(rootJ, "state", stateJ);
+#ifdef CHAOS_PROFILE
+        // Dump only, not read back
+        if (profiling)
+            json_object_set_new(rootJ, "profile", profile.toJson());
+#endif
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* integratorJ = json_object_get(rootJ, "integrator");
+        if (integratorJ)
+            integrator = clamp((int) json_integer_value(integratorJ), 0, INTEGRATORS_LEN - 1);
+        json_t* rateModeJ = json_object_get(rootJ, "rateMode");
+        if (rateModeJ)
+            rateMode = clamp((int) json_integer_value(rateModeJ), 0, RATE_MODES_LEN - 1);
+        json_t* adaptiveJ = json_object_get(rootJ, "adaptive");
+        if (adaptiveJ)
+            adaptive = json_boolean_value(adaptiveJ);
+        json_t* oversamplingJ = json_object_get(rootJ, "oversampling");
+        if (oversamplingJ)
+            oversamplingMode = clamp((int) json_integer_value(oversamplingJ), 0, OVERSAMPLING_MODES_LEN - 1);
+        json_t* qualityJ = json_object_get(rootJ, "quality");
+        if (qualityJ)
+            quality = clamp((int) json_integer_value(qualityJ), 0, QUALITIES_LEN - 1);
+        json_t* cycleCacheJ = json_object_get(rootJ, "cycleCache");
+        if (cycleCacheJ)
+            cycleCache = json_boolean_value(cycleCacheJ);
+        json_t* lfEngineJ = json_object_get(rootJ, "lfEngine");
+        if (lfEngineJ)
+            lfEngine = json_boolean_value(lfEngineJ);
+        json_t* busResetJ = json_object_get(rootJ, "busReset");
+        if (busResetJ)
+            busReset = json_boolean_value(busResetJ);
+        json_t* busRateJ = json_object_get(rootJ, "busRate");
+        if (busRateJ)
+            busRate = json_boolean_value(busRateJ);
+        json_t* busModulationJ = json_object_get(rootJ, "busModulation");
+        if (busModulationJ)
+            busModulation = json_boolean_value(busModulationJ);
+        json_t* stableRegionsJ = json_object_get(rootJ, "stableRegions");
+        if (stableRegionsJ)
+            stableRegions = json_boolean_value(stableRegionsJ);
+        json_t* warmStartJ = json_object_get(rootJ, "warmStart");
+        if (warmStartJ)
+            warmStart = json_boolean_value(warmStartJ);
+        json_t* stateJ = json_object_get(rootJ, "state");
+        if (stateJ)
+            restoreVoices(stateJ);
+        else
+            startVoices();
+    }
+};
+
+
+/** Context menu entries shared by the chaotic oscillators */
+template <class System>
+void appendChaosMenu(Menu* menu, ChaosModule<System>* module) {
+    static const std::vector<std::string> integratorNames = {"Euler", "Heun", "RK4", "Semi-implicit Euler"};
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createIndexPtrSubmenuItem("Rate CV", {"Linear", "1V/oct"}, &module->rateMode));
+    menu->addChild(createIndexPtrSubmenuItem("Quality", {"Eco", "Normal", "High", "Auto"}, &module->quality));
+    menu->addChild(createIndexPtrSubmenuItem("Integrator", integratorNames, &module->integrator));
+    menu->addChild(createBoolPtrMenuItem("Adaptive substeps", "", &module->adaptive));
+    menu->addChild(createIndexPtrSubmenuItem("Oversampling", {"Off", "2x", "4x", "8x"}, &module->oversamplingMode));
+    menu->addChild(createBoolPtrMenuItem("Cache periodic orbits", "", &module->cycleCache));
+    menu->addChild(createBoolPtrMenuItem("Decimated LF engine", "", &module->lfEngine));
+    if (System::stabilityMap())
+        menu->addChild(createBoolPtrMenuItem("Keep P1-P3 out of divergent regions", "", &module->stableRegions));
+    if (module->warmReady)
+        menu->addChild(createBoolPtrMenuItem("Start and reset on the attractor", "", &module->warmStart));
+
+    // Expander bus, any chaos module placed right next to the left
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Module on the left"));
+    menu->addChild(createBoolPtrMenuItem("Reset with it", "", &module->busReset));
+    menu->addChild(createBoolPtrMenuItem("Follow its Rate", "", &module->busRate));
+    menu->addChild(createBoolPtrMenuItem("Its X, Y, Z into P1, P2, P3 CV", "", &module->busModulation));
+#ifdef CHAOS_PROFILE
+    appendProfileMenu(menu, &module->profiling, &module->profile);
+#endif
+    appendRecordMenu(menu, module);
+    menu->addChild(new MenuSeparator);
+
+    // What is running now, Auto included, to budget the CPU of a patch
+    float steps = module->stepsPerSample();
+    int evals = ChaosModule<System>::integratorEvals(module->activeIntegrator);
+    menu->addChild(createMenuLabel(string::f("Running %s%s%s", integratorNames[module->activeIntegrator].c_str(), module->activeAdaptive ? ", adaptive" : "", module->isPrecise() ? ", double precision" : "")));
+    menu->addChild(createMenuLabel(string::f("%.1f steps, %.0f evaluations per sample", steps, steps * evals)));
+    if (module->cycleCache) {
+        int cached = 0;
+        for (int c = 0; c < module->channels; c++)
+            cached += module->isCached(c / 4);
+        menu->addChild(createMenuLabel(string::f("%d of %d voices playing a cached orbit", cached, module->channels)));
+    }
+}
@@ -0,0 +1,286 @@
+#pragma once
+#include "Attractor.hpp"
+
+
+// Periodic orbit cache.
+// Many parameter settings settle on a limit cycle, where integrating every sample only
+// regenerates the same waveform. The detector watches a Poincaré section of the live
+// trajectory, the maxima of x, and calls the orbit periodic when every return to the section
+// lands on a previous one again. One cycle is then resampled from the recent history into a
+// band-limited table, a stage at a time at control rate while the voices go on integrating,
+// which plays back until the parameters move.
+
+static const int CYCLE_TABLE_LEN = 2048;
+static const int CYCLE_HISTORY_LEN = 2048;
+static const int CYCLE_MAX_PERIOD = 1024;       // samples
+static const int CYCLE_MAX_LOOPS = 8;           // returns to the section per cycle
+static const float CYCLE_TOLERANCE = 1e-4f;     // relative distance of a return
+static const int CYCLE_REVALIDATE = 1 << 17;    // samples played before checking the orbit again
+
+
+/** Poincaré section return test of one voice */
+struct CycleDetector {
+    // Recent states
+    float history[3][CYCLE_HISTORY_LEN];
+    int64_t t = -1;
+    // Recent returns to the section, x maxima
+    double returnTime[16];
+    Vec3<float> returnPoint[16];
+    int returns = 0;
+    int loops = 0;
+    int matches = 0;
+    bool periodic = false;
+    double period = 0.0;
+
+    void clear() {
+        t = -1;
+        returns = 0;
+        loops = 0;
+        matches = 0;
+        periodic = false;
+    }
+
+    float at(int axis, int64_t i) const {
+        return history[axis][i & (CYCLE_HISTORY_LEN - 1)];
+    }
+
+    /** Adds the state of the next sample, returns whether the orbit is periodic */
+    bool process(float x, float y, float z) {
+        t++;
+        int i = t & (CYCLE_HISTORY_LEN - 1);
+        history[0][i] = x;
+        history[1][i] = y;
+        history[2][i] = z;
+        if (t < 2)
+            return false;
+
+        float x0 = at(0, t - 2);
+        float x1 = at(0, t - 1);
+        if (!(x1 > x0 && x1 >= x))
+            return periodic;
+
+        // Maximum between the three last samples, parabolic fit
+        float d = x0 - 2.f * x1 + x;
+        float offset = (d < 0.f) ? clamp(0.5f * (x0 - x) / d, -0.5f, 0.5f) : 0.f;
+        Vec3<float> p{
+            x1 - 0.25f * (x0 - x) * offset,
+            at(1, t - 1) + 0.5f * offset * (at(1, t) - at(1, t - 2)),
+            at(2, t - 1) + 0.5f * offset * (at(2, t) - at(2, t - 2))
+        };
+        double time = (double) (t - 1) + offset;
+
+        // Shortest cycle landing on this return again
+        int found = 0;
+        for (int l = 1; l <= std::min(returns, CYCLE_MAX_LOOPS) && !found; l++) {
+            const Vec3<float>& q = returnPoint[(returns - l) & 15];
+            if (std::fabs(p.x - q.x) <= CYCLE_TOLERANCE * (1.f + std::fabs(q.x))
+                && std::fabs(p.y - q.y) <= CYCLE_TOLERANCE * (1.f + std::fabs(q.y))
+                && std::fabs(p.z - q.z) <= CYCLE_TOLERANCE * (1.f + std::fabs(q.z)))
+                found = l;
+        }
+        if (found && found == loops) {
+            matches++;
+        }
+        else {
+            loops = found;
+            matches = found ? 1 : 0;
+        }
+        if (found)
+            period = time - returnTime[(returns - found) & 15];
+
+        returnTime[returns & 15] = time;
+        returnPoint[returns & 15] = p;
+        returns++;
+
+        // Every return of the cycle has to land twice
+        periodic = loops > 0 && matches > 2 * loops
+            && period >= 4.0 && period <= CYCLE_MAX_PERIOD;
+        return periodic;
+    }
+
+    /** Last return to the section, the end of the captured cycle */
+    double lastReturn() const {
+        return returnTime[(returns - 1) & 15];
+    }
+
+    /** Catmull-Rom interpolation of the history */
+    float interpolate(int axis, double time) const {
+        int64_t i = (int64_t) std::floor(time);
+        float f = time - i;
+        float y0 = at(axis, i - 1);
+        float y1 = at(axis, i);
+        float y2 = at(axis, i + 1);
+        float y3 = at(axis, std::min(i + 2, t));
+        return y1 + 0.5f * f * (y2 - y0 + f * (2.f * y0 - 5.f * y1 + 4.f * y2 - y3 + f * (3.f * (y1 - y2) + y3 - y0)));
+    }
+};
+
+
+/** One cycle of the orbit of a voice, band-limited for the period it was captured at */
+struct CycleTable {
+    alignas(16) float table[3][CYCLE_TABLE_LEN];
+    float phase;
+    float step;     // per sample at the captured rate
+    // Cycle being captured, in samples of the detector
+    double end;
+    double period;
+
+    /** Takes the last cycle of the detector, filled in by the stages of capture() */
+    void begin(const CycleDetector& detector) {
+        end = detector.lastReturn();
+        period = detector.period;
+    }
+
+    /** Stage `stage` of the capture, the two of each axis in turn: the cycle resampled from
+    the history into `spectrum` and transformed, then the harmonics that would not fit below
+    Nyquist at up to 1.1 times the captured rate removed and the table transformed back.
+    */
+    void capture(int stage, const CycleDetector& detector, dsp::RealFFT& fft, float* spectrum) {
+        float* v = table[stage / 2];
+        if (stage % 2 == 0) {
+            for (int j = 0; j < CYCLE_TABLE_LEN; j++)
+                v[j] = detector.interpolate(stage / 2, end - period + period * j / CYCLE_TABLE_LEN);
+            fft.rfft(v, spectrum);
+            return;
+        }
+        int harmonics = (int) (0.45 * period);
+        spectrum[1] = 0.f;
+        for (int h = harmonics + 1; h < CYCLE_TABLE_LEN / 2; h++)
+            spectrum[2 * h] = spectrum[2 * h + 1] = 0.f;
+        fft.irfft(spectrum, v);
+        fft.scale(v);
+    }
+
+    /** Playback from the last sample the detector has seen. `delay` in samples moves it
+    back, to match the latency of the oversampling decimators.
+    */
+    void start(const CycleDetector& detector, float delay) {
+        step = 1.f / period;
+        phase = (detector.t - end - delay) / period;
+        phase -= std::floor(phase);
+    }
+
+    /** Advances `speed` times the captured rate and returns the state there */
+    Vec3<float> process(float speed) {
+        phase += step * speed;
+        phase -= std::floor(phase);
+        float pos = phase * CYCLE_TABLE_LEN;
+        int i = (int) pos;
+        float f = pos - i;
+        float v[3];
+        for (int axis = 0; axis < 3; axis++) {
+            const float* y = table[axis];
+            float y0 = y[(i - 1) & (CYCLE_TABLE_LEN - 1)];
+            float y1 = y[i & (CYCLE_TABLE_LEN - 1)];
+            float y2 = y[(i + 1) & (CYCLE_TABLE_LEN - 1)];
+            float y3 = y[(i + 2) & (CYCLE_TABLE_LEN - 1)];
+            v[axis] = y1 + 0.5f * f * (y2 - y0 + f * (2.f * y0 - 5.f * y1 + 4.f * y2 - y3 + f * (3.f * (y1 - y2) + y3 - y0)));
+        }
+        return Vec3<float>{v[0], v[1], v[2]};
+    }
+};
+
+
+/** Cache of the 4 voices of a float_4 block. It only plays when every voice in use is
+periodic, since the block is integrated as a whole anyway.
+*/
+template <int NUM_COEFFS>
+struct CycleCache {
+    typedef simd::float_4 float_4;
+
+    // Stages of CycleTable::capture() per voice
+    static const int CAPTURE_STAGES = 6;
+
+    CycleDetector detectors[4];
+    CycleTable tables[4];
+    alignas(16) float spectrum[CYCLE_TABLE_LEN];
+    bool playing = false;
+    int captured = -1;      // stages of the capture done, -1 when not capturing
+    int lanes = 0;
+    int played = 0;
+    float_4 capturedK[NUM_COEFFS];
+    float_4 capturedH;
+
+    void clear() {
+        playing = false;
+        captured = -1;
+        for (int i = 0; i < 4; i++)
+            detectors[i].clear();
+    }
+
+    /** Whether the coefficients or the rate of a voice have left the captured ones */
+    bool moved(const float_4* k, float_4 h) const {
+        int mask = 0;
+        for (int i = 0; i < NUM_COEFFS; i++)
+            mask |= simd::movemask(simd::abs(k[i] - capturedK[i]) > 1e-5f * simd::abs(capturedK[i]));
+        mask |= simd::movemask(h > 1.1f * capturedH);
+        return mask & ((1 << lanes) - 1);
+    }
+
+    /** Feeds the integrated state of the block, with `lanes` voices in use, and begins a
+    capture when all of them are periodic. The capture is dropped when a voice stops being
+    periodic, or the coefficients or the voices change, before update() has finished it.
+    `h` is the time advanced per sample.
+    */
+    void detect(const Vec3<float_4>& s, int lanes, const float_4* k, float_4 h) {
+        bool periodic = true;
+        for (int i = 0; i < lanes; i++)
+            periodic = detectors[i].process(s.x[i], s.y[i], s.z[i]) && periodic;
+        if (captured >= 0) {
+            if (!periodic || lanes != this->lanes || moved(k, h))
+                captured = -1;
+            return;
+        }
+        if (!periodic || (simd::movemask(h <= 0.f) & ((1 << lanes) - 1)))
+            return;
+
+        for (int i = 0; i < lanes; i++)
+            tables[i].begin(detectors[i]);
+        for (int i = 0; i < NUM_COEFFS; i++)
+            capturedK[i] = k[i];
+        capturedH = h;
+        this->lanes = lanes;
+        captured = 0;
+    }
+
+    /** One stage of the capture at control rate, then playback once the last one is done,
+    the voices integrating meanwhile. At one stage per tick of 16 samples, the last cycle is
+    resampled less than 400 samples after detect() took it, long before the history of the
+    detector has moved past its start. `delay` as in CycleTable::start().
+    */
+    void update(dsp::RealFFT& fft, float delay) {
+        if (captured < 0)
+            return;
+        int stage = captured++;
+        int voice = stage / CAPTURE_STAGES;
+        tables[voice].capture(stage % CAPTURE_STAGES, detectors[voice], fft, spectrum);
+        if (captured < CAPTURE_STAGES * lanes)
+            return;
+
+        for (int i = 0; i < lanes; i++)
+            tables[i].start(detectors[i], delay);
+        captured = -1;
+        played = 0;
+        playing = true;
+    }
+
+    /** Next state of the cached orbits into `s`. Stops, with `s` on the orbit for the
+    integration to go on from there, when the coefficients move, the rate goes over the
+    band limit, the voices change, or after a while to check that the orbit still holds.
+    */
+    bool process(Vec3<float_4>& s, int lanes, const float_4* k, float_4 h) {
+        if (moved(k, h) || lanes != this->lanes || ++played >= CYCLE_REVALIDATE) {
+            clear();
+            return false;
+        }
+
+        float_4 speed = h / capturedH;
+        for (int i = 0; i < lanes; i++) {
+            Vec3<float> v = tables[i].process(speed[i]);
+            s.x[i] = v.x;
+            s.y[i] = v.y;
+            s.z[i] = v.z;
+        }
+        return true;
+    }
+};
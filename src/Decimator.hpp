@@ -0,0 +1,124 @@
+#pragma once
+#include "plugin.hpp"
+
+
+// Half-band FIR coefficients, Kaiser window, odd taps from the center outwards.
+// Every even tap is zero except the center one, which is 0.5.
+// Each stage only has to protect the band that survives the following ones,
+// so the first stages of the cascade are much shorter than the last.
+static const float HALFBAND_8X[4] = {     // 8x to 4x, stopband -74 dB from 0.4375
+    0.294244066f, -0.0507018324f, 0.00654597557f, -8.8208655e-05f
+};
+static const float HALFBAND_4X[5] = {     // 4x to 2x, stopband -67 dB from 0.375
+    0.305887928f, -0.0733410843f, 0.0215620594f, -0.004318747f, 0.000209843574f
+};
+static const float HALFBAND_2X[12] = {    // 2x to 1x, stopband -72 dB from 0.3, passband to 0.2
+    0.316301925f, -0.100218996f, 0.0542711069f, -0.0331443383f, 0.0208013357f, -0.0128856162f,
+    0.00767782754f, -0.00429892243f, 0.00219813684f, -0.000980640208f, 0.000346381141f, -6.82007751e-05f
+};
+
+
+/** Half-band FIR decimating by 2, split in its two polyphase branches.
+The branch of the older sample of each pair is a pure delay to the center tap,
+the other one holds the K symmetric pairs of odd taps, so each output costs K products.
+Delay lines are written twice so that they can be read without wrapping.
+*/
+template <int K, typename T>
+struct HalfBandDecimator {
+    const float* h;
+    T even[4 * K];
+    T odd[2 * K];
+    int evenPos = 0;
+    int oddPos = 0;
+
+    HalfBandDecimator(const float* h) : h(h) {
+        reset(0.f);
+    }
+
+    void reset(T value) {
+        for (int i = 0; i < 4 * K; i++)
+            even[i] = value;
+        for (int i = 0; i < 2 * K; i++)
+            odd[i] = value;
+    }
+
+    template <typename M>
+    void reset(T value, M mask) {
+        for (int i = 0; i < 4 * K; i++)
+            even[i] = simd::ifelse(mask, value, even[i]);
+        for (int i = 0; i < 2 * K; i++)
+            odd[i] = simd::ifelse(mask, value, odd[i]);
+    }
+
+    /** Takes two consecutive samples, in0 first, and returns one */
+    T process(T in0, T in1) {
+        evenPos = (evenPos == 0) ? 2 * K - 1 : evenPos - 1;
+        even[evenPos] = even[evenPos + 2 * K] = in1;
+        oddPos = (oddPos == 0) ? K - 1 : oddPos - 1;
+        odd[oddPos] = odd[oddPos + K] = in0;
+
+        const T* e = &even[evenPos];
+        T y = 0.5f * odd[oddPos + K - 1];
+        for (int j = 0; j < K; j++)
+            y += h[j] * (e[K - 1 - j] + e[K + j]);
+        return y;
+    }
+};
+
+
+/** Cascade of half-band decimators for 2x, 4x and 8x oversampling */
+template <typename T>
+struct Decimator {
+    HalfBandDecimator<4, T> stage8{HALFBAND_8X};
+    HalfBandDecimator<5, T> stage4{HALFBAND_4X};
+    HalfBandDecimator<12, T> stage2{HALFBAND_2X};
+
+    /** Fills the delay lines with a constant signal, to avoid a transient */
+    void reset(T value) {
+        stage8.reset(value);
+        stage4.reset(value);
+        stage2.reset(value);
+    }
+
+    /** Same for the lanes in `mask` only, the others going on undisturbed */
+    template <typename M>
+    void reset(T value, M mask) {
+        stage8.reset(value, mask);
+        stage4.reset(value, mask);
+        stage2.reset(value, mask);
+    }
+
+    /** Group delay in output samples */
+    static float latency(int factor) {
+        float delay = 0.f;
+        if (factor >= 8)
+            delay += (2 * 4 - 1) / 8.f;
+        if (factor >= 4)
+            delay += (2 * 5 - 1) / 4.f;
+        if (factor >= 2)
+            delay += (2 * 12 - 1) / 2.f;
+        return delay;
+    }
+
+    /** Takes `factor` samples and returns one */
+    T process(const T* in, int factor) {
+        T in4[4];
+        T in2[2];
+        switch (factor) {
+            case 8:
+                for (int i = 0; i < 4; i++)
+                    in4[i] = stage8.process(in[2 * i], in[2 * i + 1]);
+                in = in4;
+                // fallthrough
+            case 4:
+                for (int i = 0; i < 2; i++)
+                    in2[i] = stage4.process(in[2 * i], in[2 * i + 1]);
+                in = in2;
+                // fallthrough
+            case 2:
+                return stage2.process(in[0], in[1]);
+            default:
+                return in[0];
+        }
+    }
+};
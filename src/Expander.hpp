@@ -0,0 +1,48 @@
+#pragma once
+#include "plugin.hpp"
+
+
+/** What a chaos module hands to the one on its right through the expander messages.
+Each module owns the two buffers of its left side and Rack swaps them after every sample,
+so nothing is allocated or locked while running.
+*/
+struct ChaosBus {
+    typedef simd::float_4 float_4;
+
+    int channels = 0;       // 0 until the module on the left writes
+    float_4 rate[4];        // time advanced per sample, 0 to 1 of the Rate range
+    float_4 reset[4];       // reset triggers, its own and the ones it received
+    float_4 x[4];           // outputs in volts
+    float_4 y[4];
+    float_4 z[4];
+
+    /** Block of `v` for the voices from channel `c`, a single channel going to all of them */
+    float_4 get(const float_4* v, int c) const {
+        return (channels == 1) ? float_4(v[0][0]) : v[c / 4];
+    }
+
+    /** Whether the voices from channel `c` have a counterpart on the left */
+    bool has(int c) const {
+        return channels == 1 || c < channels;
+    }
+};
+
+
+inline bool isChaosModule(Module* m) {
+    return m && (m->model == modelJulioChua || m->model == modelJulioRossler || m->model == modelJulioLorentz84 || m->model == modelJulioODE);
+}
+
+/** Message from the module on the left of `m`, or null */
+inline const ChaosBus* leftBus(Module* m) {
+    if (!isChaosModule(m->leftExpander.module))
+        return nullptr;
+    const ChaosBus* bus = (const ChaosBus*) m->leftExpander.consumerMessage;
+    return bus->channels > 0 ? bus : nullptr;
+}
+
+/** Message to write for the module on the right of `m`, or null */
+inline ChaosBus* rightBus(Module* m) {
+    if (!isChaosModule(m->rightExpander.module))
+        return nullptr;
+    return (ChaosBus*) m->rightExpander.module->leftExpander.producerMessage;
+}
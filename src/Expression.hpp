@@ -0,0 +1,575 @@
+#pragma once
+#include "Precise.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+// Expressions of the custom attractor.
+// Each derivative is parsed into a tree, folded where the operands are constant, and
+// compiled into register code: every instruction reads one or two registers and writes
+// another, registers 0 to 2 holding x, y, z and 3 to 5 the parameters. Running it is a
+// loop over a few instructions with no allocation, templated on the lane type like the
+// derivatives of the built-in systems.
+
+namespace expr {
+
+// Elementary functions of every lane type. log, sqrt and fractional powers take the
+// absolute value, so that a lane does not turn NaN on the way, and tanh saturates instead
+// of overflowing.
+
+inline double sin(double a) { return std::sin(a); }
+inline double cos(double a) { return std::cos(a); }
+inline double exp(double a) { return std::exp(a); }
+inline double log(double a) { return std::log(std::fabs(a)); }
+inline double sqrt(double a) { return std::sqrt(std::fabs(a)); }
+inline double abs(double a) { return std::fabs(a); }
+inline double min(double a, double b) { return std::fmin(a, b); }
+inline double max(double a, double b) { return std::fmax(a, b); }
+
+inline float sin(float a) { return std::sin(a); }
+inline float cos(float a) { return std::cos(a); }
+inline float exp(float a) { return std::exp(a); }
+inline float log(float a) { return std::log(std::fabs(a)); }
+inline float sqrt(float a) { return std::sqrt(std::fabs(a)); }
+inline float abs(float a) { return std::fabs(a); }
+inline float min(float a, float b) { return std::fmin(a, b); }
+inline float max(float a, float b) { return std::fmax(a, b); }
+
+inline simd::float_4 sin(simd::float_4 a) { return simd::sin(a); }
+inline simd::float_4 cos(simd::float_4 a) { return simd::cos(a); }
+inline simd::float_4 exp(simd::float_4 a) { return simd::exp(a); }
+inline simd::float_4 log(simd::float_4 a) { return simd::log(simd::abs(a)); }
+inline simd::float_4 sqrt(simd::float_4 a) { return simd::sqrt(simd::abs(a)); }
+inline simd::float_4 abs(simd::float_4 a) { return simd::abs(a); }
+inline simd::float_4 min(simd::float_4 a, simd::float_4 b) { return simd::fmin(a, b); }
+inline simd::float_4 max(simd::float_4 a, simd::float_4 b) { return simd::fmax(a, b); }
+
+#define EXPR_DOUBLE4_UNARY(fn) \
+    inline Double4 fn(const Double4& a) { \
+        Double4 r; \
+        for (int i = 0; i < 4; i++) \
+            r.v[i] = expr::fn(a.v[i]); \
+        return r; \
+    }
+
+#define EXPR_DOUBLE4_BINARY(fn) \
+    inline Double4 fn(const Double4& a, const Double4& b) { \
+        Double4 r; \
+        for (int i = 0; i < 4; i++) \
+            r.v[i] = expr::fn(a.v[i], b.v[i]); \
+        return r; \
+    }
+
+EXPR_DOUBLE4_UNARY(sin)
+EXPR_DOUBLE4_UNARY(cos)
+EXPR_DOUBLE4_UNARY(exp)
+EXPR_DOUBLE4_UNARY(log)
+EXPR_DOUBLE4_UNARY(sqrt)
+EXPR_DOUBLE4_UNARY(abs)
+EXPR_DOUBLE4_BINARY(min)
+EXPR_DOUBLE4_BINARY(max)
+
+#undef EXPR_DOUBLE4_UNARY
+#undef EXPR_DOUBLE4_BINARY
+
+template <typename T>
+inline T tanh(const T& a) {
+    return 1.f - 2.f / (expr::exp(2.f * a) + 1.f);
+}
+
+template <typename T>
+inline T pow(const T& a, const T& b) {
+    return expr::exp(b * expr::log(a));
+}
+
+inline void load(double& r, double c) { r = c; }
+inline void load(float& r, double c) { r = (float) c; }
+inline void load(simd::float_4& r, double c) { r = simd::float_4((float) c); }
+inline void load(Double4& r, double c) { r = Double4(c); }
+
+
+enum Op : uint8_t {
+    OP_CONST,   // dst = constants[a]
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MIN,
+    OP_MAX,
+    OP_POW,
+    OP_ADDK,    // dst = a + constants[b], and so on
+    OP_SUBK,
+    OP_MULK,
+    OP_KSUB,    // dst = constants[b] - a
+    OP_KDIV,    // dst = constants[b] / a
+    OP_NEG,
+    OP_POWI,    // dst = a^b, b from 2 to MAX_POWI
+    OP_SIN,
+    OP_COS,
+    OP_TANH,
+    OP_EXP,
+    OP_LOG,
+    OP_SQRT,
+    OP_ABS,
+    OP_REG,     // only in the tree, register a
+};
+
+static const int MAX_REGS = 32;
+static const int MAX_CODE = 256;
+static const int MAX_CONSTANTS = 64;
+static const int MAX_POWI = 8;
+static const int MAX_DEPTH = 64;
+// Registers below FIRST_TEMP are the inputs, x, y, z, P1, P2, P3
+static const int FIRST_TEMP = 6;
+
+struct Instruction {
+    uint8_t op;
+    uint8_t dst;
+    uint8_t a;
+    uint8_t b;
+};
+
+
+/** Register code of the three derivatives */
+struct Program {
+    Instruction code[MAX_CODE];
+    double constants[MAX_CONSTANTS];
+    int length = 0;
+    int numConstants = 0;
+    uint8_t out[3] = {};
+
+    template <typename T>
+    T constant(int i) const {
+        T c;
+        load(c, constants[i]);
+        return c;
+    }
+
+    /** Derivative at s with parameters k */
+    template <typename T>
+    Vec3<T> run(const Vec3<T>& s, const T* k) const {
+        T r[MAX_REGS];
+        r[0] = s.x;
+        r[1] = s.y;
+        r[2] = s.z;
+        r[3] = k[0];
+        r[4] = k[1];
+        r[5] = k[2];
+        for (const Instruction* in = code; in < code + length; in++) {
+            switch (in->op) {
+                case OP_CONST: load(r[in->dst], constants[in->a]); break;
+                case OP_ADD: r[in->dst] = r[in->a] + r[in->b]; break;
+                case OP_SUB: r[in->dst] = r[in->a] - r[in->b]; break;
+                case OP_MUL: r[in->dst] = r[in->a] * r[in->b]; break;
+                case OP_DIV: r[in->dst] = r[in->a] / r[in->b]; break;
+                case OP_MIN: r[in->dst] = expr::min(r[in->a], r[in->b]); break;
+                case OP_MAX: r[in->dst] = expr::max(r[in->a], r[in->b]); break;
+                case OP_POW: r[in->dst] = expr::pow(r[in->a], r[in->b]); break;
+                case OP_ADDK: r[in->dst] = r[in->a] + constant<T>(in->b); break;
+                case OP_SUBK: r[in->dst] = r[in->a] - constant<T>(in->b); break;
+                case OP_MULK: r[in->dst] = r[in->a] * constant<T>(in->b); break;
+                case OP_KSUB: r[in->dst] = constant<T>(in->b) - r[in->a]; break;
+                case OP_KDIV: r[in->dst] = constant<T>(in->b) / r[in->a]; break;
+                case OP_NEG: r[in->dst] = -r[in->a]; break;
+                case OP_POWI: {
+                    T p = r[in->a];
+                    for (int i = 1; i < in->b; i++)
+                        p = p * r[in->a];
+                    r[in->dst] = p;
+                } break;
+                case OP_SIN: r[in->dst] = expr::sin(r[in->a]); break;
+                case OP_COS: r[in->dst] = expr::cos(r[in->a]); break;
+                case OP_TANH: r[in->dst] = expr::tanh(r[in->a]); break;
+                case OP_EXP: r[in->dst] = expr::exp(r[in->a]); break;
+                case OP_LOG: r[in->dst] = expr::log(r[in->a]); break;
+                case OP_SQRT: r[in->dst] = expr::sqrt(r[in->a]); break;
+                case OP_ABS: r[in->dst] = expr::abs(r[in->a]); break;
+                default: break;
+            }
+        }
+        return Vec3<T>{r[out[0]], r[out[1]], r[out[2]]};
+    }
+};
+
+
+/** Value of `op` on constants, the same functions as the program in double precision */
+inline double fold(Op op, double a, double b) {
+    switch (op) {
+        case OP_ADD: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return a / b;
+        case OP_MIN: return expr::min(a, b);
+        case OP_MAX: return expr::max(a, b);
+        case OP_POW: return expr::pow(a, b);
+        case OP_NEG: return -a;
+        case OP_POWI: return std::pow(a, b);
+        case OP_SIN: return expr::sin(a);
+        case OP_COS: return expr::cos(a);
+        case OP_TANH: return expr::tanh(a);
+        case OP_EXP: return expr::exp(a);
+        case OP_LOG: return expr::log(a);
+        case OP_SQRT: return expr::sqrt(a);
+        case OP_ABS: return expr::abs(a);
+        default: return a;
+    }
+}
+
+
+/** Parser of the derivatives and code generator.
+
+Expressions take numbers, pi, the variables x, y, z, the parameters p1, p2, p3 or the names
+given to them, + - * / ^ and parentheses, and the functions sin, cos, tanh, exp, log, sqrt,
+abs, min, max and pow. Errors leave a message in `error`.
+*/
+struct Compiler {
+    struct Node {
+        Op op;
+        int a;
+        int b;          // second operand, or the exponent of OP_POWI
+        double value;   // of OP_CONST
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::pair<std::string, int>> names;
+    std::string error;
+    const char* begin = nullptr;
+    const char* p = nullptr;
+    int depth = 0;
+
+    Compiler() {
+        addName("x", 0);
+        addName("y", 1);
+        addName("z", 2);
+        addName("p1", 3);
+        addName("p2", 4);
+        addName("p3", 5);
+    }
+
+    /** Another name for register `reg`, false if it is taken */
+    bool addName(const std::string& name, int reg) {
+        if (name == "pi" || findFunction(name, nullptr) || findName(name) >= 0)
+            return false;
+        names.push_back(std::make_pair(name, reg));
+        return true;
+    }
+
+    int findName(const std::string& name) const {
+        for (const auto& n : names) {
+            if (n.first == name)
+                return n.second;
+        }
+        return -1;
+    }
+
+    static bool findFunction(const std::string& name, Op* op, int* arity = nullptr) {
+        static const struct {
+            const char* name;
+            Op op;
+            int arity;
+        } functions[] = {
+            {"sin", OP_SIN, 1}, {"cos", OP_COS, 1}, {"tanh", OP_TANH, 1}, {"exp", OP_EXP, 1},
+            {"log", OP_LOG, 1}, {"sqrt", OP_SQRT, 1}, {"abs", OP_ABS, 1},
+            {"min", OP_MIN, 2}, {"max", OP_MAX, 2}, {"pow", OP_POW, 2},
+        };
+        for (const auto& f : functions) {
+            if (name == f.name) {
+                if (op)
+                    *op = f.op;
+                if (arity)
+                    *arity = f.arity;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Tree of `text`, or -1 */
+    int parse(const std::string& text) {
+        begin = p = text.c_str();
+        depth = 0;
+        int n = parseSum();
+        if (n < 0)
+            return -1;
+        skip();
+        if (*p)
+            return fail(std::string("unexpected '") + *p + "'");
+        return n;
+    }
+
+    /** Code of the three trees into `program`, each derivative multiplied by `scale` */
+    bool generate(Program& program, const int roots[3], double scale) {
+        program.length = 0;
+        program.numConstants = 0;
+        int top = FIRST_TEMP;
+        for (int i = 0; i < 3; i++)
+            program.out[i] = emit(program, make(OP_MUL, roots[i], constant(scale)), top);
+        return error.empty();
+    }
+
+private:
+    int fail(const std::string& message) {
+        if (error.empty())
+            error = message + " at " + std::to_string((int) (p - begin) + 1);
+        return -1;
+    }
+
+    void skip() {
+        while (*p == ' ' || *p == '\t')
+            p++;
+    }
+
+    int constant(double value) {
+        nodes.push_back(Node{OP_CONST, -1, -1, value});
+        return nodes.size() - 1;
+    }
+
+    bool isConstant(int n, double value) const {
+        return nodes[n].op == OP_CONST && nodes[n].value == value;
+    }
+
+    /** Node of `op`, folded when the operands are constant */
+    int make(Op op, int a, int b = -1) {
+        bool unary = (b < 0);
+        if (nodes[a].op == OP_CONST && (unary || nodes[b].op == OP_CONST))
+            return constant(fold(op, nodes[a].value, unary ? 0.0 : nodes[b].value));
+        // (a * c1) * c2 as a * (c1 * c2)
+        if (op == OP_MUL && nodes[b].op == OP_CONST && nodes[a].op == OP_MUL && nodes[nodes[a].b].op == OP_CONST)
+            return make(OP_MUL, nodes[a].a, constant(nodes[nodes[a].b].value * nodes[b].value));
+        if ((op == OP_MUL && isConstant(a, 1.0)) || (op == OP_ADD && isConstant(a, 0.0)))
+            return b;
+        if (((op == OP_MUL || op == OP_DIV) && isConstant(b, 1.0)) || ((op == OP_ADD || op == OP_SUB) && isConstant(b, 0.0)))
+            return a;
+        nodes.push_back(Node{op, a, b, 0.0});
+        return nodes.size() - 1;
+    }
+
+    /** a^b, as multiplications when b is a small integer */
+    int power(int a, int b) {
+        double e = nodes[b].value;
+        if (nodes[b].op != OP_CONST || e != std::round(e) || std::fabs(e) > MAX_POWI)
+            return make(OP_POW, a, b);
+        int n = std::abs((int) e);
+        int r = a;
+        if (n == 0)
+            return constant(1.0);
+        if (n > 1) {
+            if (nodes[a].op == OP_CONST)
+                return constant(std::pow(nodes[a].value, e));
+            nodes.push_back(Node{OP_POWI, a, n, 0.0});
+            r = nodes.size() - 1;
+        }
+        return (e < 0) ? make(OP_DIV, constant(1.0), r) : r;
+    }
+
+    int parseSum() {
+        int a = parseProduct();
+        while (a >= 0) {
+            skip();
+            char c = *p;
+            if (c != '+' && c != '-')
+                break;
+            p++;
+            int b = parseProduct();
+            if (b < 0)
+                return -1;
+            a = make(c == '+' ? OP_ADD : OP_SUB, a, b);
+        }
+        return a;
+    }
+
+    int parseProduct() {
+        int a = parseUnary();
+        while (a >= 0) {
+            skip();
+            char c = *p;
+            if (c != '*' && c != '/')
+                break;
+            p++;
+            int b = parseUnary();
+            if (b < 0)
+                return -1;
+            a = make(c == '*' ? OP_MUL : OP_DIV, a, b);
+        }
+        return a;
+    }
+
+    int parseUnary() {
+        if (++depth > MAX_DEPTH)
+            return fail("too deep");
+        skip();
+        int n;
+        if (*p == '-' || *p == '+') {
+            bool minus = (*p == '-');
+            p++;
+            n = parseUnary();
+            if (n >= 0 && minus)
+                n = make(OP_NEG, n);
+        }
+        else {
+            n = parsePower();
+        }
+        depth--;
+        return n;
+    }
+
+    // Binds tighter than a sign on its left, -x^2 is -(x^2), and groups to the right
+    int parsePower() {
+        int a = parsePrimary();
+        if (a < 0)
+            return -1;
+        skip();
+        if (*p != '^')
+            return a;
+        p++;
+        int b = parseUnary();
+        if (b < 0)
+            return -1;
+        return power(a, b);
+    }
+
+    int parsePrimary() {
+        skip();
+        if (std::isdigit((unsigned char) *p) || *p == '.') {
+            char* end;
+            double value = std::strtod(p, &end);
+            if (end == p)
+                return fail("bad number");
+            p = end;
+            return constant(value);
+        }
+        if (std::isalpha((unsigned char) *p) || *p == '_') {
+            const char* start = p;
+            while (std::isalnum((unsigned char) *p) || *p == '_')
+                p++;
+            std::string name(start, p);
+            skip();
+            Op op;
+            int arity;
+            if (*p == '(' && findFunction(name, &op, &arity)) {
+                p++;
+                int args[2] = {-1, -1};
+                for (int i = 0; i < arity; i++) {
+                    if (i > 0) {
+                        skip();
+                        if (*p != ',')
+                            return fail(name + " takes " + std::to_string(arity) + " arguments");
+                        p++;
+                    }
+                    args[i] = parseSum();
+                    if (args[i] < 0)
+                        return -1;
+                }
+                skip();
+                if (*p != ')')
+                    return fail("missing )");
+                p++;
+                return make(op, args[0], args[1]);
+            }
+            if (name == "pi")
+                return constant(M_PI);
+            int reg = findName(name);
+            if (reg < 0) {
+                p = start;
+                return fail("unknown name '" + name + "'");
+            }
+            nodes.push_back(Node{OP_REG, reg, -1, 0.0});
+            return nodes.size() - 1;
+        }
+        if (*p == '(') {
+            p++;
+            int n = parseSum();
+            if (n < 0)
+                return -1;
+            skip();
+            if (*p != ')')
+                return fail("missing )");
+            p++;
+            return n;
+        }
+        if (!*p)
+            return fail("unexpected end");
+        return fail(std::string("unexpected '") + *p + "'");
+    }
+
+    int addConstant(Program& program, double value) {
+        for (int i = 0; i < program.numConstants; i++) {
+            if (program.constants[i] == value)
+                return i;
+        }
+        if (program.numConstants >= MAX_CONSTANTS) {
+            error = "too many constants";
+            return 0;
+        }
+        program.constants[program.numConstants] = value;
+        return program.numConstants++;
+    }
+
+    void append(Program& program, Op op, int dst, int a, int b) {
+        if (program.length >= MAX_CODE) {
+            error = "too long";
+            return;
+        }
+        program.code[program.length++] = Instruction{op, (uint8_t) dst, (uint8_t) a, (uint8_t) b};
+    }
+
+    // Registers from FIRST_TEMP are used as a stack: the result of a node goes to the
+    // first one its operands took, so a tree needs as many as it is deep
+    int allocate(int& top) {
+        if (top >= MAX_REGS) {
+            error = "too deep";
+            return FIRST_TEMP;
+        }
+        return top++;
+    }
+
+    /** Emits node n, returning the register of its value */
+    int emit(Program& program, int n, int& top) {
+        const Node node = nodes[n];
+        if (node.op == OP_REG)
+            return node.a;
+        if (node.op == OP_CONST) {
+            int dst = allocate(top);
+            append(program, OP_CONST, dst, addConstant(program, node.value), 0);
+            return dst;
+        }
+        bool unary = (node.op == OP_POWI || node.b < 0);
+
+        // A constant operand goes into the instruction instead of a register
+        if (!unary && (node.op == OP_ADD || node.op == OP_SUB || node.op == OP_MUL || node.op == OP_DIV)) {
+            const Node& na = nodes[node.a];
+            const Node& nb = nodes[node.b];
+            Op op = OP_REG;
+            int operand = -1;
+            double value = 0.0;
+            if (nb.op == OP_CONST) {
+                op = (node.op == OP_ADD) ? OP_ADDK : (node.op == OP_SUB) ? OP_SUBK : OP_MULK;
+                operand = node.a;
+                value = (node.op == OP_DIV) ? 1.0 / nb.value : nb.value;
+            }
+            else if (na.op == OP_CONST) {
+                op = (node.op == OP_ADD) ? OP_ADDK : (node.op == OP_SUB) ? OP_KSUB : (node.op == OP_MUL) ? OP_MULK : OP_KDIV;
+                operand = node.b;
+                value = na.value;
+            }
+            if (operand >= 0) {
+                int ra = emit(program, operand, top);
+                int dst = (ra >= FIRST_TEMP) ? ra : allocate(top);
+                append(program, op, dst, ra, addConstant(program, value));
+                top = dst + 1;
+                return dst;
+            }
+        }
+
+        int ra = emit(program, node.a, top);
+        int rb = unary ? node.b : emit(program, node.b, top);
+        int dst = (ra >= FIRST_TEMP) ? ra : (!unary && rb >= FIRST_TEMP) ? rb : allocate(top);
+        append(program, node.op, dst, ra, std::max(rb, 0));
+        top = dst + 1;
+        return dst;
+    }
+};
+
+} // namespace expr
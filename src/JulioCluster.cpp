@@ -0,0 +1,518 @@
+#include "plugin.hpp"
+#include "ChaosModule.hpp"
+#include "Network.hpp"
+
+
+static const int MAX_NODES = 16;
+static const int MAX_COEFFS = Chua::NUM_COEFFS;
+
+
+/** Network of up to 16 oscillators of one of the systems, diffusively coupled on x.
+All nodes are solved as one System of 4 * blocks lanes, so each node sees the others at every
+substep, instead of one sample late through cables and one process() per node.
+*/
+struct JulioCluster : Module, Recordable {
+    typedef simd::float_4 float_4;
+
+    enum ParamId {
+        RATE_PARAM,
+        P1_PARAM,
+        P2_PARAM,
+        P3_PARAM,
+        CVRATE_PARAM,
+        CVP1_PARAM,
+        CVP2_PARAM,
+        CVP3_PARAM,
+        RANGE_PARAM,
+        COUPLING_PARAM,
+        CVCOUPLING_PARAM,
+        PARAMS_LEN
+    };
+    enum InputId {
+        INRATE_INPUT,
+        INP1_INPUT,
+        INP2_INPUT,
+        INP3_INPUT,
+        INRESET_INPUT,
+        INCOUPLING_INPUT,
+        INPUTS_LEN
+    };
+    enum OutputId {
+        X_OUTPUT,
+        Y_OUTPUT,
+        Z_OUTPUT,
+        OUTPUTS_LEN
+    };
+    enum LightId {
+        RANGE_LIGHT,
+        LIGHTS_LEN
+    };
+
+    enum Systems {
+        SYSTEM_CHUA,
+        SYSTEM_ROSSLER,
+        SYSTEM_LORENTZ84,
+        SYSTEMS_LEN
+    };
+    enum Topologies {
+        TOPOLOGY_RING,
+        TOPOLOGY_ALL,
+        TOPOLOGY_RANDOM,
+        TOPOLOGIES_LEN
+    };
+    enum Integrators {
+        INTEGRATOR_EULER,
+        INTEGRATOR_HEUN,
+        INTEGRATOR_RK4,
+        INTEGRATOR_SEMI_IMPLICIT,
+        INTEGRATORS_LEN
+    };
+    int system = SYSTEM_CHUA;
+    int topology = TOPOLOGY_RING;
+    int nodes = 8;
+    uint32_t seed = 1;
+    int integrator = INTEGRATOR_EULER;
+
+    // Setup running now, updated at control rate
+    int activeSystem = -1;
+    int activeNodes = 0;
+    int activeTopology = -1;
+    uint32_t activeSeed = 0;
+    int blocks = 1;
+
+    float sr = 0.f;
+    bool range = false;
+    float rateScale;
+    int substeps = 1;
+
+    // Parameters are evaluated every PARAM_DIVISION samples and ramped in between,
+    // as in ChaosModule
+    static const int PARAM_DIVISION = 16;
+    bool paramsReady = false;
+    bool rateConnected = false;
+    bool cvConnected[3] = {};
+    bool couplingConnected = false;
+    float rateMax;
+    float gainRate;
+    float gain[MAX_COEFFS];
+    float couplingMax;
+    float couplingGain;
+    LinearRamp rateRamp;
+    LinearRamp coeffRamp[MAX_COEFFS];
+    LinearRamp couplingRamp;
+
+    // Weight of node j in the mean of node i, rows adding up to 1
+    float weights[MAX_NODES][MAX_NODES];
+    // Coefficients of the Coupled system, each one `blocks` float_4 long: the ones of the
+    // system, the coupling and the columns of the weights
+    float_4 k[(MAX_COEFFS + 1 + MAX_NODES) * 4];
+
+    AttractorState<NodeVector<4>> state;
+    dsp::TSchmittTrigger<float_4> resetTrigger[4];
+    dsp::ClockDivider lightDivider;
+    dsp::ClockDivider paramDivider;
+
+#ifdef CHAOS_PROFILE
+    // Instrumentation, see Profile.hpp
+    bool profiling = false;
+    ProfileCounters profile;
+
+    ProfileCounters* counters() {
+        return profiling ? &profile : nullptr;
+    }
+#endif
+
+    JulioCluster() {
+        config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        configParam(RATE_PARAM, 0.f, 1.f, 0.f, "Rate");
+        configParam(P1_PARAM, 0.f, 1.f, 0.5f, "P1");
+        configParam(P2_PARAM, 0.f, 1.f, 0.5f, "P2");
+        configParam(P3_PARAM, 0.f, 1.f, 0.5f, "P3");
+        configParam(CVRATE_PARAM, -1.f, 1.f, 0.f, "Rate CV");
+        configParam(CVP1_PARAM, -1.f, 1.f, 0.f, "P1 CV");
+        configParam(CVP2_PARAM, -1.f, 1.f, 0.f, "P2 CV");
+        configParam(CVP3_PARAM, -1.f, 1.f, 0.f, "P3 CV");
+        configSwitch(RANGE_PARAM, 0.f, 1.f, 0.f, "Fq Range", {"HF", "LF"});
+        configParam(COUPLING_PARAM, 0.f, 1.f, 0.f, "Coupling", "%", 0.f, 100.f);
+        configParam(CVCOUPLING_PARAM, -1.f, 1.f, 0.f, "Coupling CV");
+        configInput(INRATE_INPUT, "Rate");
+        configInput(INP1_INPUT, "P1");
+        configInput(INP2_INPUT, "P2");
+        configInput(INP3_INPUT, "P3");
+        configInput(INRESET_INPUT, "Reset");
+        configInput(INCOUPLING_INPUT, "Coupling");
+        configOutput(X_OUTPUT, "X");
+        configOutput(Y_OUTPUT, "Y");
+        configOutput(Z_OUTPUT, "Z");
+
+        lightDivider.setDivision(16);
+        paramDivider.setDivision(PARAM_DIVISION);
+    }
+
+    void process(const ProcessArgs& args) override {
+        PROFILE_SAMPLE(counters());
+        if (!paramsReady || paramDivider.process())
+            processParams(args.sampleRate);
+
+        switch (activeSystem) {
+            default:
+            case SYSTEM_CHUA: processSystem<Chua>(); break;
+            case SYSTEM_ROSSLER: processSystem<Rossler>(); break;
+            case SYSTEM_LORENTZ84: processSystem<Lorentz84>(); break;
+        }
+        recorder.push([&](int b) {
+            return Vec3<float_4>{state.preDC.x.v[b], state.preDC.y.v[b], state.preDC.z.v[b]};
+        });
+        outputs[X_OUTPUT].setChannels(activeNodes);
+        outputs[Y_OUTPUT].setChannels(activeNodes);
+        outputs[Z_OUTPUT].setChannels(activeNodes);
+
+        // Lights
+        if (lightDivider.process()) {
+            lights[RANGE_LIGHT].setBrightness(range);
+        }
+    }
+
+    /** Control rate: system, links, range and parameter maps */
+    void processParams(float sampleRate) {
+        switch (system) {
+            default:
+            case SYSTEM_CHUA: processParams<Chua>(sampleRate); break;
+            case SYSTEM_ROSSLER: processParams<Rossler>(sampleRate); break;
+            case SYSTEM_LORENTZ84: processParams<Lorentz84>(sampleRate); break;
+        }
+    }
+
+    template <class System>
+    void processParams(float sampleRate) {
+        // A new system starts every node again, from its own initial conditions
+        bool restart = system != activeSystem;
+        if (restart) {
+            activeSystem = system;
+            Attractor<Coupled<System>, EulerIntegrator, MAX_NODES>::init(state);
+            paramsReady = false;
+        }
+
+        // Nodes and links, the weights change place in the coefficients with the blocks
+        if (restart || nodes != activeNodes || topology != activeTopology || seed != activeSeed) {
+            activeNodes = clamp(nodes, 1, MAX_NODES);
+            activeTopology = topology;
+            activeSeed = seed;
+            blocks = (activeNodes + 3) / 4;
+            updateWeights();
+            loadWeights(System::NUM_COEFFS + 1);
+        }
+
+        // Frequency range, steps of the original 48 kHz length
+        range = params[RANGE_PARAM].getValue() > 0.f;
+        rateScale = range ? System::RATE_LF : System::RATE_HF;
+        int oversampling = range ? 1 : System::SUBSTEPS_HF;
+        sr = sampleRate;
+        substeps = std::max(1, (int) std::lround(oversampling * 48000.f / sr));
+
+        rateConnected = inputs[INRATE_INPUT].isConnected();
+        for (int p = 0; p < 3; p++)
+            cvConnected[p] = inputs[INP1_INPUT + p].isConnected();
+        couplingConnected = inputs[INCOUPLING_INPUT].isConnected();
+
+        // Parameters, the coupling goes up with the square of the knob for finer control
+        // around the threshold of synchronization
+        rateMax = rateScale / sr;
+        float rateTarget = params[RATE_PARAM].getValue() * rateMax;
+        gainRate = params[CVRATE_PARAM].getValue() * rateScale * 0.037f / sr;
+        float coeffTarget[System::NUM_COEFFS];
+        for (int i = 0; i < System::NUM_COEFFS; i++) {
+            const ParamMap m = System::paramMap(i);
+            coeffTarget[i] = params[P1_PARAM + m.param].getValue() * m.scale + m.offset;
+            if (!cvConnected[m.param])
+                coeffTarget[i] = clamp(coeffTarget[i], m.min, m.max);
+            gain[i] = params[CVP1_PARAM + m.param].getValue() * m.cv;
+        }
+        couplingMax = System::COUPLING_MAX;
+        float coupling = params[COUPLING_PARAM].getValue();
+        float couplingTarget = coupling * coupling * couplingMax;
+        couplingGain = params[CVCOUPLING_PARAM].getValue() * couplingMax * 0.1f;
+
+        if (!paramsReady) {
+            rateRamp.jump(rateTarget);
+            for (int i = 0; i < System::NUM_COEFFS; i++)
+                coeffRamp[i].jump(coeffTarget[i]);
+            couplingRamp.jump(couplingTarget);
+            paramsReady = true;
+        }
+        else {
+            rateRamp.setTarget(rateTarget, PARAM_DIVISION);
+            for (int i = 0; i < System::NUM_COEFFS; i++)
+                coeffRamp[i].setTarget(coeffTarget[i], PARAM_DIVISION);
+            couplingRamp.setTarget(couplingTarget, PARAM_DIVISION);
+        }
+    }
+
+    /** Links of the topology, every node pulled by the mean of its neighbours */
+    void updateWeights() {
+        int n = activeNodes;
+        bool links[MAX_NODES][MAX_NODES] = {};
+        if (n > 1) {
+            switch (activeTopology) {
+                default:
+                case TOPOLOGY_RING:
+                    for (int i = 0; i < n; i++)
+                        links[i][(i + 1) % n] = links[(i + 1) % n][i] = true;
+                    break;
+                case TOPOLOGY_ALL:
+                    for (int i = 0; i < n; i++)
+                        for (int j = 0; j < n; j++)
+                            links[i][j] = i != j;
+                    break;
+                case TOPOLOGY_RANDOM: {
+                    // Two links from each node to any other, xorshift from the saved seed
+                    uint32_t r = activeSeed ? activeSeed : 1;
+                    for (int i = 0; i < n; i++) {
+                        for (int l = 0; l < 2; l++) {
+                            r ^= r << 13;
+                            r ^= r >> 17;
+                            r ^= r << 5;
+                            int j = (i + 1 + r % (n - 1)) % n;
+                            links[i][j] = links[j][i] = true;
+                        }
+                    }
+                } break;
+            }
+        }
+
+        for (int i = 0; i < MAX_NODES; i++) {
+            int degree = 0;
+            for (int j = 0; j < MAX_NODES; j++)
+                degree += links[i][j];
+            for (int j = 0; j < MAX_NODES; j++)
+                weights[i][j] = links[i][j] ? 1.f / degree : 0.f;
+            // A node with no links is its own mean, free instead of pulled to 0
+            if (degree == 0)
+                weights[i][i] = 1.f;
+        }
+    }
+
+    /** Weight columns into the coefficients, starting at coefficient `first` */
+    void loadWeights(int first) {
+        for (int j = 0; j < 4 * blocks; j++) {
+            for (int i = 0; i < 4 * blocks; i++)
+                k[(first + j) * blocks + i / 4][i % 4] = weights[i][j];
+        }
+    }
+
+    template <class System>
+    void processSystem() {
+        switch (integrator) {
+            default:
+            case INTEGRATOR_EULER: processBlocks<System, EulerIntegrator>(); break;
+            case INTEGRATOR_HEUN: processBlocks<System, HeunIntegrator>(); break;
+            case INTEGRATOR_RK4: processBlocks<System, RK4Integrator>(); break;
+            case INTEGRATOR_SEMI_IMPLICIT: processBlocks<System, SemiImplicitIntegrator>(); break;
+        }
+    }
+
+    template <class System, class Integrator>
+    void processBlocks() {
+        switch (blocks) {
+            default:
+            case 1: processNodes<System, Integrator, 1>(); break;
+            case 2: processNodes<System, Integrator, 2>(); break;
+            case 3: processNodes<System, Integrator, 3>(); break;
+            case 4: processNodes<System, Integrator, 4>(); break;
+        }
+    }
+
+    template <class System, class Integrator, int B>
+    void processNodes() {
+        typedef typename LaneType<4 * B>::type T;
+        typedef Attractor<Coupled<System>, Integrator, 4 * B> Solver;
+        T* kn = reinterpret_cast<T*>(k);
+
+        float rate = rateRamp.process();
+        float coeffs[System::NUM_COEFFS];
+        for (int i = 0; i < System::NUM_COEFFS; i++)
+            coeffs[i] = coeffRamp[i].process();
+        float coupling = couplingRamp.process();
+
+        // CV per node, only on connected inputs
+        T h;
+        T resetBang;
+        for (int b = 0; b < B; b++) {
+            int c = 4 * b;
+            float_4 hb = rate;
+            if (rateConnected) {
+                float_4 CVrate = inputs[INRATE_INPUT].getPolyVoltageSimd<float_4>(c) * gainRate;
+                hb = simd::clamp(hb + CVrate, 0.f, rateMax);
+            }
+            block(h, b) = hb;
+
+            float_4 cv[3] = {};
+            for (int p = 0; p < 3; p++) {
+                if (cvConnected[p])
+                    cv[p] = inputs[INP1_INPUT + p].getPolyVoltageSimd<float_4>(c);
+            }
+            for (int i = 0; i < System::NUM_COEFFS; i++) {
+                const ParamMap m = System::paramMap(i);
+                float_4 kb = coeffs[i];
+                if (cvConnected[m.param])
+                    kb = simd::clamp(kb + cv[m.param] * gain[i], m.min, m.max);
+                block(kn[i], b) = kb;
+            }
+            float_4 eps = coupling;
+            if (couplingConnected) {
+                float_4 CVcoupling = inputs[INCOUPLING_INPUT].getPolyVoltageSimd<float_4>(c) * couplingGain;
+                eps = simd::clamp(eps + CVcoupling, 0.f, couplingMax);
+            }
+            block(kn[System::NUM_COEFFS], b) = eps;
+
+            float_4 resetSignal = inputs[INRESET_INPUT].getPolyVoltageSimd<float_4>(c);
+            block(resetBang, b) = resetTrigger[b].process(resetSignal, 0.1f, 2.f);
+        }
+
+        // Solution, reset and DC blocker of every node at once, in the wide kernel of the CPU
+        // if it has one, see Kernels.hpp
+        AttractorState<T> st;
+        loadNodes(st, state);
+        WideKernel kernel = (B > 1) ? networkKernel<System>(integrator) : nullptr;
+        typename LaneType<4 * B>::mask resetMask;
+        if (kernel) {
+            kernel(reinterpret_cast<float*>(&st.s.x), reinterpret_cast<float*>(&st.s.y), reinterpret_cast<float*>(&st.s.z), reinterpret_cast<const float*>(k), reinterpret_cast<const float*>(&h), 4 * B, substeps);
+            resetMask = Solver::finish(st, resetBang);
+        }
+        else {
+            resetMask = Solver::process(st, kn, h, substeps, resetBang);
+        }
+        storeNodes(state, st);
+        PROFILE_COUNT(counters(), voiceSamples, activeNodes);
+        PROFILE_COUNT(counters(), steps, substeps * activeNodes);
+        profileResets<B>(resetBang, resetMask);
+
+        // Outputs, one channel per node
+        PROFILE_SECTION(SECTION_OUTPUT);
+        Vec3<T> out = System::output(st.postDC);
+        for (int b = 0; b < B; b++) {
+            outputs[X_OUTPUT].setVoltageSimd(block(out.x, b), 4 * b);
+            outputs[Y_OUTPUT].setVoltageSimd(block(out.y, b), 4 * b);
+            outputs[Z_OUTPUT].setVoltageSimd(block(out.z, b), 4 * b);
+        }
+    }
+
+    /** Resets of the nodes for the profiler, from the Reset input or the divergence test */
+    template <int B, typename T, typename M>
+    void profileResets(const T& resetBang, const M& resetMask) {
+#ifdef CHAOS_PROFILE
+        for (int b = 0; b < B; b++) {
+            int lanes = (1 << clamp(activeNodes - 4 * b, 0, 4)) - 1;
+            int bang = simd::movemask(block(resetBang, b)) & lanes;
+            PROFILE_COUNT(counters(), triggerResets, __builtin_popcount(bang));
+            PROFILE_COUNT(counters(), divergenceResets, __builtin_popcount(simd::movemask(block(resetMask, b)) & lanes & ~bang));
+        }
+#endif
+    }
+
+    /** The nodes as voices, and the system after the slug */
+    RecordHeader recordHeader() override {
+        static const char* const systemNames[SYSTEMS_LEN] = {"Chua", "Rossler", "Lorentz84"};
+        RecordHeader h;
+        std::strncpy(h.system, string::f("JulioCluster %s", systemNames[system]).c_str(), sizeof(h.system) - 1);
+        h.sampleRate = sr;
+        h.channels = activeNodes;
+        h.integrator = integrator;
+        for (int i = 0; i < PARAMS_LEN; i++)
+            h.params[i] = params[i].getValue();
+        return h;
+    }
+
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "system", json_integer(system));
+        json_object_set_new(rootJ, "topology", json_integer(topology));
+        json_object_set_new(rootJ, "nodes", json_integer(nodes));
+        json_object_set_new(rootJ, "seed", json_integer(seed));
+        json_object_set_new(rootJ, "integrator", json_integer(integrator));
+#ifdef CHAOS_PROFILE
+        // Dump only, not read back
+        if (profiling)
+            json_object_set_new(rootJ, "profile", profile.toJson());
+#endif
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* systemJ = json_object_get(rootJ, "system");
+        if (systemJ)
+            system = clamp((int) json_integer_value(systemJ), 0, SYSTEMS_LEN - 1);
+        json_t* topologyJ = json_object_get(rootJ, "topology");
+        if (topologyJ)
+            topology = clamp((int) json_integer_value(topologyJ), 0, TOPOLOGIES_LEN - 1);
+        json_t* nodesJ = json_object_get(rootJ, "nodes");
+        if (nodesJ)
+            nodes = clamp((int) json_integer_value(nodesJ), 1, MAX_NODES);
+        json_t* seedJ = json_object_get(rootJ, "seed");
+        if (seedJ)
+            seed = (uint32_t) json_integer_value(seedJ);
+        json_t* integratorJ = json_object_get(rootJ, "integrator");
+        if (integratorJ)
+            integrator = clamp((int) json_integer_value(integratorJ), 0, INTEGRATORS_LEN - 1);
+    }
+};
+
+
+struct JulioClusterWidget : ModuleWidget {
+    JulioClusterWidget(JulioCluster* module) {
+        setModule(module);
+        setPanel(createPanel(asset::plugin(pluginInstance, "res/JulioCluster.svg")));
+
+        addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, 0)));
+        addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0)));
+        addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+        addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(10.5, 26.602)), module, JulioCluster::RATE_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(50.46, 26.602)), module, JulioCluster::COUPLING_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(10.5, 56.017)), module, JulioCluster::P1_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(30.48, 56.017)), module, JulioCluster::P2_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(50.46, 56.017)), module, JulioCluster::P3_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(7.0, 80.59)), module, JulioCluster::CVRATE_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(18.74, 80.59)), module, JulioCluster::CVP1_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(30.48, 80.59)), module, JulioCluster::CVP2_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(42.22, 80.59)), module, JulioCluster::CVP3_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(53.96, 80.59)), module, JulioCluster::CVCOUPLING_PARAM));
+        addParam(createLightParamCentered<VCVLightLatch<MediumSimpleLight<WhiteLight>>>(mm2px(Vec(30.48, 26.602)), module, JulioCluster::RANGE_PARAM, JulioCluster::RANGE_LIGHT));
+
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.0, 97.459)), module, JulioCluster::INRATE_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(18.74, 97.459)), module, JulioCluster::INP1_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(30.48, 97.459)), module, JulioCluster::INP2_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(42.22, 97.459)), module, JulioCluster::INP3_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(53.96, 97.459)), module, JulioCluster::INCOUPLING_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.0, 113.438)), module, JulioCluster::INRESET_INPUT));
+
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(30.48, 113.438)), module, JulioCluster::X_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(42.22, 113.438)), module, JulioCluster::Y_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(53.96, 113.438)), module, JulioCluster::Z_OUTPUT));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        JulioCluster* module = dynamic_cast<JulioCluster*>(this->module);
+        std::vector<std::string> nodeLabels;
+        for (int n = 1; n <= MAX_NODES; n++)
+            nodeLabels.push_back(string::f("%d", n));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createIndexPtrSubmenuItem("System", {"Chua", "Rossler", "Lorentz84"}, &module->system));
+        menu->addChild(createIndexSubmenuItem("Nodes", nodeLabels,
+            [=]() { return module->nodes - 1; },
+            [=](size_t i) { module->nodes = i + 1; }));
+        menu->addChild(createIndexPtrSubmenuItem("Topology", {"Ring", "All to all", "Random"}, &module->topology));
+        menu->addChild(createMenuItem("New random links", "",
+            [=]() { module->seed = random::u32(); },
+            module->topology != JulioCluster::TOPOLOGY_RANDOM));
+        menu->addChild(createIndexPtrSubmenuItem("Integrator", {"Euler", "Heun", "RK4", "Semi-implicit Euler"}, &module->integrator));
+#ifdef CHAOS_PROFILE
+        appendProfileMenu(menu, &module->profiling, &module->profile);
+#endif
+        appendRecordMenu(menu, module);
+    }
+};
+
+Model* modelJulioCluster = createModel<JulioCluster, JulioClusterWidget>("JulioCluster");
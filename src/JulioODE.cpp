@@ -0,0 +1,383 @@
+#include "plugin.hpp"
+#include "ChaosModule.hpp"
+#include "UserSystem.hpp"
+#include <mutex>
+#include <thread>
+
+
+thread_local const UserProgram* UserSystem::program = nullptr;
+
+
+struct ODEPreset {
+    const char* name;
+    const char* equations[3];
+    const char* params[3];
+};
+
+static const ODEPreset presets[] = {
+    {"Lorenz", {"sigma*(y - x)", "x*(rho - z) - y", "x*y - beta*z"}, {"sigma 5 15", "rho 20 40", "beta 1 4"}},
+    {"Thomas", {"sin(y) - b*x", "sin(z) - b*y", "sin(x) - b*z"}, {"b 0.1 0.25", "", ""}},
+    {"Aizawa", {"(z - 0.7)*x - d*y", "d*x + (z - 0.7)*y", "0.6 + a*z - z^3/3 - (x^2 + y^2)*(1 + 0.25*z) + f*z*x^3"}, {"a 0.8 1", "d 2.5 4.5", "f 0 0.2"}},
+    {"Halvorsen", {"-a*x - 4*y - 4*z - y^2", "-a*y - 4*z - 4*x - z^2", "-a*z - 4*x - 4*y - x^2"}, {"a 1.2 1.6", "", ""}},
+};
+
+// Seconds after the last keystroke in the menu before the texts are compiled
+static const double COMPILE_IDLE = 0.4;
+
+
+struct JulioODE : ChaosModule<UserSystem> {
+    // Text of the derivatives and of the parameters, edited on the UI thread
+    std::string equations[3];
+    std::string paramDefs[3];
+    std::string status;
+
+    // Programs are sent from the UI thread to the audio thread through `pending`, and the
+    // ones they replace go back through `retired` to be deleted, so that the audio thread
+    // never allocates, frees or waits. `inFlight` keeps both rings from filling up.
+    UserProgram* program;
+    SpscRing<UserProgram*, 16> pending;
+    SpscRing<UserProgram*, 16> retired;
+    UserProgram* waiting = nullptr;
+    int inFlight = 0;
+
+    // The edits are compiled by a thread of their own, a compile running the new system for
+    // CALIBRATION_STEPS steps, and only COMPILE_IDLE after the last keystroke or on Enter.
+    // Under `buildMutex`, the texts it is to compile next and the last program it built,
+    // tagged with the generation of its request so that a patch loaded meanwhile wins.
+    double editTime = -1.0;
+    std::thread builder;
+    std::mutex buildMutex;
+    bool building = false;
+    bool requested = false;
+    int generation = 0;
+    std::string requestEquations[3];
+    std::string requestParams[3];
+    bool builtReady = false;
+    int builtGeneration = 0;
+    UserProgram* built = nullptr;
+    std::string builtStatus;
+
+    JulioODE() {
+        setPreset(0);
+        program = build(equations, paramDefs, status);
+        startVoices();
+    }
+
+    ~JulioODE() {
+        if (builder.joinable())
+            builder.join();
+        delete built;
+        UserProgram* p;
+        while (pending.pop(p))
+            delete p;
+        while (retired.pop(p))
+            delete p;
+        delete waiting;
+        delete program;
+    }
+
+    void process(const ProcessArgs& args) override {
+        UserProgram* p;
+        while (pending.pop(p)) {
+            retired.push(program);
+            program = p;
+            restart(p->keepVoices);
+        }
+        UserSystem::program = program;
+        ChaosModule<UserSystem>::process(args);
+        recover();
+    }
+
+    /** Voices from the start, unless `keep`, and parameters without ramps, for a new program */
+    void restart(bool keep) {
+        paramsReady = false;
+        loadWarmStates();
+        if (!keep)
+            startVoices();
+    }
+
+    // Set on the UI thread too, where UserSystem has no program
+    const float* warmTable(bool lf) override {
+        return program ? program->warm : nullptr;
+    }
+
+    /** Lanes gone NaN, which the divergence test does not catch, start again */
+    void recover() {
+        ChaosBus* next = rightBus(this);
+        for (int b = 0; b < (channels + 3) / 4; b++) {
+            const Vec3<float_4>& s = voices[b].s;
+            float_4 nan = (s.x != s.x) | (s.y != s.y) | (s.z != s.z);
+            if (!simd::movemask(nan))
+                continue;
+            Attractor<UserSystem, EulerIntegrator>::reset(voices[b].s, nan);
+            AttractorState<float_4>& st = voices[b];
+            st.preDC = Vec3<float_4>{select(nan, 0.f, st.preDC.x), select(nan, 0.f, st.preDC.y), select(nan, 0.f, st.preDC.z)};
+            st.postDC = Vec3<float_4>{select(nan, 0.f, st.postDC.x), select(nan, 0.f, st.postDC.y), select(nan, 0.f, st.postDC.z)};
+            precise[b] = false;
+            segments[b].active = false;
+            if (warmStart && warmReady)
+                warmReset(b, nan);
+            resetDecimators(b);
+            setOutputs(b, next);
+        }
+    }
+
+    void setPreset(int i) {
+        for (int j = 0; j < 3; j++) {
+            equations[j] = presets[i].equations[j];
+            paramDefs[j] = presets[i].params[j];
+        }
+    }
+
+    /** Program of the texts, or null, with the result or the error in `result` */
+    static UserProgram* build(const std::string equations[3], const std::string paramDefs[3], std::string& result) {
+        UserProgram* p = new UserProgram;
+        if (!p->compile(equations, paramDefs)) {
+            result = p->error;
+            delete p;
+            return nullptr;
+        }
+        result = string::f("%d instructions, period %.3g", p->code.length, p->period);
+        return p;
+    }
+
+    /** UI thread: a text was edited, compiled once the typing stops */
+    void edit() {
+        editTime = system::getTime();
+    }
+
+    /** UI thread: has the current texts compiled by the builder thread, collect() then sends
+    the program to the audio thread when it is valid
+    */
+    void compile() {
+        editTime = -1.0;
+        status = "Compiling...";
+        std::lock_guard<std::mutex> lock(buildMutex);
+        for (int i = 0; i < 3; i++) {
+            requestEquations[i] = equations[i];
+            requestParams[i] = paramDefs[i];
+        }
+        requested = true;
+        generation++;
+        if (building)
+            return;
+        // Done with its last request, or never started
+        if (builder.joinable())
+            builder.join();
+        building = true;
+        builder = std::thread([this]() {
+            buildRequests();
+        });
+    }
+
+    /** Builder thread: the latest request until there is none left */
+    void buildRequests() {
+        std::unique_lock<std::mutex> lock(buildMutex);
+        while (requested) {
+            std::string e[3], d[3];
+            for (int i = 0; i < 3; i++) {
+                e[i] = requestEquations[i];
+                d[i] = requestParams[i];
+            }
+            int g = generation;
+            requested = false;
+            lock.unlock();
+            std::string result;
+            UserProgram* p = build(e, d, result);
+            lock.lock();
+            delete built;
+            built = p;
+            builtStatus = result;
+            builtGeneration = g;
+            builtReady = true;
+        }
+        building = false;
+    }
+
+    /** UI thread: compiles after an edit once the typing stops, takes what the builder built,
+    deletes the programs the audio thread is done with and sends the waiting one
+    */
+    void collect() {
+        if (editTime >= 0.0 && system::getTime() - editTime >= COMPILE_IDLE)
+            compile();
+        {
+            std::lock_guard<std::mutex> lock(buildMutex);
+            if (builtReady && builtGeneration == generation) {
+                status = builtStatus;
+                if (built) {
+                    delete waiting;
+                    waiting = built;
+                    built = nullptr;
+                }
+            }
+            builtReady = false;
+        }
+        UserProgram* p;
+        while (retired.pop(p)) {
+            delete p;
+            inFlight--;
+        }
+        if (waiting && inFlight < 15 && pending.push(waiting)) {
+            waiting = nullptr;
+            inFlight++;
+        }
+    }
+
+    json_t* dataToJson() override {
+        json_t* rootJ = ChaosModule<UserSystem>::dataToJson();
+        json_t* equationsJ = json_array();
+        json_t* paramsJ = json_array();
+        for (int i = 0; i < 3; i++) {
+            json_array_append_new(equationsJ, json_string(equations[i].c_str()));
+            json_array_append_new(paramsJ, json_string(paramDefs[i].c_str()));
+        }
+        json_object_set_new(rootJ, "equations", equationsJ);
+        json_object_set_new(rootJ, "params", paramsJ);
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        ChaosModule<UserSystem>::dataFromJson(rootJ);
+        json_t* equationsJ = json_object_get(rootJ, "equations");
+        json_t* paramsJ = json_object_get(rootJ, "params");
+        for (int i = 0; i < 3; i++) {
+            json_t* equationJ = json_array_get(equationsJ, i);
+            if (equationJ)
+                equations[i] = json_string_value(equationJ);
+            json_t* paramJ = json_array_get(paramsJ, i);
+            if (paramJ)
+                paramDefs[i] = json_string_value(paramJ);
+        }
+        // Compiled here, so that the patch starts with its own program. A build still running
+        // for an earlier edit is dropped by the new generation.
+        {
+            std::lock_guard<std::mutex> lock(buildMutex);
+            requested = false;
+            generation++;
+        }
+        editTime = -1.0;
+        UserProgram* p = build(equations, paramDefs, status);
+        if (p) {
+            // Set before the program is sent, which publishes it to the audio thread
+            p->keepVoices = json_object_get(rootJ, "state");
+            delete waiting;
+            waiting = p;
+            collect();
+        }
+    }
+};
+
+
+/** Menu text field for one of the texts of the module, compiled when the typing stops or on
+Enter
+*/
+struct ExpressionField : ui::TextField {
+    JulioODE* module;
+    std::string* target;
+
+    ExpressionField() {
+        box.size.x = 240.f;
+    }
+
+    void onChange(const ChangeEvent& e) override {
+        *target = text;
+        module->edit();
+    }
+
+    void onAction(const ActionEvent& e) override {
+        module->compile();
+    }
+};
+
+/** Menu label with the result of the last compilation */
+struct StatusLabel : ui::MenuLabel {
+    JulioODE* module;
+
+    void step() override {
+        text = module->status;
+        ui::MenuLabel::step();
+    }
+};
+
+
+struct JulioODEWidget : ModuleWidget {
+    JulioODEWidget(JulioODE* module) {
+        setModule(module);
+        setPanel(createPanel(asset::plugin(pluginInstance, "res/JulioODE.svg")));
+
+        addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, 0)));
+        addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0)));
+        addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+        addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(12.566, 26.602)), module, JulioODE::RATE_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(32.821, 26.602)), module, JulioODE::P1_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(12.566, 56.017)), module, JulioODE::P2_PARAM));
+        addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(32.821, 56.017)), module, JulioODE::P3_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(6.656, 80.59)), module, JulioODE::CVRATE_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(17.443, 80.59)), module, JulioODE::CVP1_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(28.293, 80.59)), module, JulioODE::CVP2_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(39.061, 80.59)), module, JulioODE::CVP3_PARAM));
+        addParam(createLightParamCentered<VCVLightLatch<MediumSimpleLight<WhiteLight>>>(mm2px(Vec(22.694, 42.309)), module, JulioODE::RANGE_PARAM, JulioODE::RANGE_LIGHT));
+
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.452, 97.459)), module, JulioODE::INRATE_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(17.089, 97.459)), module, JulioODE::INP1_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(28.424, 97.459)), module, JulioODE::INP2_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(39.061, 97.459)), module, JulioODE::INP3_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.452, 113.438)), module, JulioODE::INRESET_INPUT));
+
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(17.089, 113.438)), module, JulioODE::X_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(28.424, 113.438)), module, JulioODE::Y_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(39.061, 113.438)), module, JulioODE::Z_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(6.604, 40.301)), module, JulioODE::LYAP_OUTPUT));
+        addChild(createLightCentered<SmallLight<RedLight>>(mm2px(Vec(12.869, 41.994)), module, JulioODE::CHAOS_LIGHT));
+
+        addChild(createPhaseScope(Vec(3.0, 64.5), Vec(39.72, 12.0), module ? &module->scope : NULL));
+    }
+
+    void step() override {
+        JulioODE* module = dynamic_cast<JulioODE*>(this->module);
+        if (module)
+            module->collect();
+        ModuleWidget::step();
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        static const char* equationLabels[3] = {"dx/dt", "dy/dt", "dz/dt"};
+        JulioODE* module = dynamic_cast<JulioODE*>(this->module);
+
+        menu->addChild(new MenuSeparator);
+        for (int i = 0; i < 3; i++) {
+            menu->addChild(createMenuLabel(equationLabels[i]));
+            ExpressionField* field = new ExpressionField;
+            field->module = module;
+            field->target = &module->equations[i];
+            field->text = module->equations[i];
+            menu->addChild(field);
+        }
+        // Optional name and the values at both ends of the knob
+        for (int i = 0; i < 3; i++) {
+            menu->addChild(createMenuLabel(string::f("P%d: name, from, to", i + 1)));
+            ExpressionField* field = new ExpressionField;
+            field->module = module;
+            field->target = &module->paramDefs[i];
+            field->text = module->paramDefs[i];
+            menu->addChild(field);
+        }
+        StatusLabel* status = new StatusLabel;
+        status->module = module;
+        menu->addChild(status);
+        menu->addChild(createSubmenuItem("Presets", "", [=](Menu* menu) {
+            for (int i = 0; i < (int) LENGTHOF(presets); i++) {
+                menu->addChild(createMenuItem(presets[i].name, "", [=]() {
+                    module->setPreset(i);
+                    module->compile();
+                }));
+            }
+        }));
+
+        appendChaosMenu(menu, module);
+    }
+};
+
+Model* modelJulioODE = createModel<JulioODE, JulioODEWidget>("JulioODE");
@@ -0,0 +1,40 @@
+#include "Kernels.hpp"
+
+
+const WideKernels wideKernelsSSE = {"SSE", 4, {}, {}};
+const WideKernels* wideKernels = &wideKernelsSSE;
+
+
+/** Whether the CPU, and the operating system saving its registers, runs a set */
+static bool supported(const WideKernels* set) {
+    if (!set)
+        return false;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (set == wideKernelsAVX512)
+        return __builtin_cpu_supports("avx512f");
+    if (set == wideKernelsAVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    return set == &wideKernelsSSE;
+}
+
+
+void selectWideKernels() {
+    wideKernels = &wideKernelsSSE;
+    if (supported(wideKernelsAVX512))
+        wideKernels = wideKernelsAVX512;
+    else if (supported(wideKernelsAVX2))
+        wideKernels = wideKernelsAVX2;
+}
+
+
+bool selectWideKernels(const std::string& name) {
+    for (const WideKernels* set : {&wideKernelsSSE, wideKernelsAVX2, wideKernelsAVX512}) {
+        if (set && name == set->name && supported(set)) {
+            wideKernels = set;
+            return true;
+        }
+    }
+    return false;
+}
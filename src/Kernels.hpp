@@ -0,0 +1,84 @@
+#pragma once
+#include "Systems.hpp"
+
+
+// Integration of up to 16 voices, or of the nodes of a network, in the widest vectors of the
+// CPU. Rack builds for SSE, so the kernels for AVX2 and AVX-512 live in translation units of
+// their own, where only they target those instruction sets, see Wide.hpp, and init() picks
+// the widest set the CPU runs. The SSE set has no kernels, the modules then step their float_4
+// blocks.
+
+/** Substeps of one integrator over `lanes` lanes: the state in x, y, z, each coefficient in a
+row of `lanes` floats one after the other, and the step of each lane in h
+*/
+typedef void (*WideKernel)(float* x, float* y, float* z, const float* k, const float* h, int lanes, int substeps);
+
+// Systems in the order of the tables
+enum WideSystems {
+    WIDE_CHUA,
+    WIDE_ROSSLER,
+    WIDE_LORENTZ84,
+    WIDE_SYSTEMS_LEN
+};
+
+// Integrators in the order of the menus: Euler, Heun, RK4, semi-implicit Euler
+static const int WIDE_INTEGRATORS = 4;
+
+struct WideKernels {
+    const char* name;
+    int width;          // floats per instruction
+    // Independent voices of a System, and the nodes of Coupled<System>
+    WideKernel voices[WIDE_SYSTEMS_LEN][WIDE_INTEGRATORS];
+    WideKernel network[WIDE_SYSTEMS_LEN][WIDE_INTEGRATORS];
+};
+
+// Null when the build has no compiler support for them
+extern const WideKernels wideKernelsSSE;
+extern const WideKernels* const wideKernelsAVX2;
+extern const WideKernels* const wideKernelsAVX512;
+
+/** Set in use, SSE until init() */
+extern const WideKernels* wideKernels;
+
+/** Picks the widest set the CPU and the operating system support, called from init() */
+void selectWideKernels();
+
+/** Forces a set by name, "SSE", "AVX2" or "AVX-512", for the benchmark. False when the build
+or the CPU lacks it.
+*/
+bool selectWideKernels(const std::string& name);
+
+
+template <class System>
+struct WideSystem {
+    static constexpr int ID = -1;
+};
+
+template <>
+struct WideSystem<Chua> {
+    static constexpr int ID = WIDE_CHUA;
+};
+
+template <>
+struct WideSystem<Rossler> {
+    static constexpr int ID = WIDE_ROSSLER;
+};
+
+template <>
+struct WideSystem<Lorentz84> {
+    static constexpr int ID = WIDE_LORENTZ84;
+};
+
+/** Kernel of the voices of System, or null to step them in float_4 blocks */
+template <class System>
+inline WideKernel voicesKernel(int integrator) {
+    int id = WideSystem<System>::ID;
+    return (id < 0) ? nullptr : wideKernels->voices[id][integrator];
+}
+
+/** Kernel of a network of System, or null */
+template <class System>
+inline WideKernel networkKernel(int integrator) {
+    int id = WideSystem<System>::ID;
+    return (id < 0) ? nullptr : wideKernels->network[id][integrator];
+}
@@ -0,0 +1,14 @@
+// Kernels of Kernels.hpp for AVX2, the only code built for it, see Wide.hpp
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WIDE_ISA "avx2,fma"
+#include "Wide.hpp"
+
+
+static constexpr WideKernels kernels = makeWideKernels("AVX2", 8);
+const WideKernels* const wideKernelsAVX2 = &kernels;
+#else
+#include "Kernels.hpp"
+
+
+const WideKernels* const wideKernelsAVX2 = nullptr;
+#endif
@@ -0,0 +1,14 @@
+// Kernels of Kernels.hpp for AVX-512, the only code built for it, see Wide.hpp
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WIDE_ISA "avx512f"
+#include "Wide.hpp"
+
+
+static constexpr WideKernels kernels = makeWideKernels("AVX-512", 16);
+const WideKernels* const wideKernelsAVX512 = &kernels;
+#else
+#include "Kernels.hpp"
+
+
+const WideKernels* const wideKernelsAVX512 = nullptr;
+#endif
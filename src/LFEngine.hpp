@@ -0,0 +1,54 @@
+#pragma once
+#include "Attractor.hpp"
+
+
+// Decimated LF engine.
+// In LF range the outputs are sub-audio, so the state only needs solving every few samples.
+// Each block is solved LF_DECIMATION samples ahead in steps as long as the HF ones, and the
+// output follows the trajectory between the two states by cubic Hermite interpolation, using
+// the derivatives at both ends. A reset starts a new segment at the same sample.
+
+static const int LF_DECIMATION = 16;
+
+
+/** Trajectory of a block between two solved states, LF_DECIMATION samples apart */
+struct LFSegment {
+    typedef simd::float_4 float_4;
+
+    Vec3<float_4> p0, p1;   // states at both ends
+    Vec3<float_4> m0, m1;   // derivatives times the time of the segment
+    Vec3<float_4> point;    // last output
+    float_4 h;              // time per sample
+    int pos = 0;
+    int substeps = 1;
+    bool active = false;
+
+    void start(const Vec3<float_4>& p0, const Vec3<float_4>& p1, const Vec3<float_4>& d0, const Vec3<float_4>& d1, float_4 time) {
+        this->p0 = p0;
+        this->p1 = p1;
+        m0 = Vec3<float_4>{d0.x * time, d0.y * time, d0.z * time};
+        m1 = Vec3<float_4>{d1.x * time, d1.y * time, d1.z * time};
+        pos = 0;
+        active = true;
+    }
+
+    bool done() const {
+        return pos >= LF_DECIMATION;
+    }
+
+    /** Next sample of the segment, ending exactly on p1 */
+    Vec3<float_4> process() {
+        pos++;
+        float t = (float) pos / LF_DECIMATION;
+        float t2 = t * t;
+        float t3 = t2 * t;
+        float h00 = 2.f * t3 - 3.f * t2 + 1.f;
+        float h10 = t3 - 2.f * t2 + t;
+        float h01 = 3.f * t2 - 2.f * t3;
+        float h11 = t3 - t2;
+        point.x = h00 * p0.x + h10 * m0.x + h01 * p1.x + h11 * m1.x;
+        point.y = h00 * p0.y + h10 * m0.y + h01 * p1.y + h11 * m1.y;
+        point.z = h00 * p0.z + h10 * m0.z + h01 * p1.z + h11 * m1.z;
+        return point;
+    }
+};
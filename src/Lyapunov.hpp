@@ -0,0 +1,155 @@
+#pragma once
+#include "Attractor.hpp"
+
+
+// Running estimate of the largest Lyapunov exponent, the chaos meter.
+// A tangent vector is carried along the solution of each voice by the Jacobian of the system
+// at the middle of the solution over each step, its exponential taken to the fourth order.
+// The steps are TANGENT_STEP of the system long whatever the integrator and the substeps:
+// shorter samples are gathered into one step at the state in the middle of them, and longer
+// ones are split. Plain Euler steps would add the rotation of the tangent to its growth, and
+// read several volts too high at the top of the HF range.
+// The audio path only records the samples, and the tangent follows them at control rate,
+// where it is renormalized and the logarithm of its growth over the time elapsed feeds an
+// average of the exponent over LYAPUNOV_PERIODS periods.
+
+static const float LYAPUNOV_PERIODS = 100.f;
+static const float LYAPUNOV_VOLTS = 10.f;       // per nat of growth per period
+static const int LYAPUNOV_GATHER_MAX = 64;      // samples gathered into one step
+static const int LYAPUNOV_PATH = 16;            // samples recorded between two updates
+
+
+/** Tangent vectors of 4 voices and the estimate of their largest exponent */
+template <class System>
+struct LyapunovMeter {
+    typedef simd::float_4 float_4;
+
+    /** One sample of the solution, from s0 to s1 */
+    struct Sample {
+        Vec3<float_4> s0;
+        Vec3<float_4> s1;
+        float_4 k[System::NUM_COEFFS];
+        float_4 dt;
+        float_4 resetMask;
+    };
+
+    Vec3<float_4> v;
+    float_4 time;           // of the system since the last renormalization
+    float_4 exponent;       // per unit of time of the system
+    float_4 span;           // averaged so far, up to the time of LYAPUNOV_PERIODS
+    // Samples since the last update
+    Sample path[LYAPUNOV_PATH];
+    int recorded = 0;
+    // Samples gathered into the next step
+    Vec3<float_4> middle;
+    float_4 pending;
+    int gathered;
+    int gather;
+
+    void reset() {
+        restart(float_4::mask());
+        exponent = 0.f;
+        span = 0.f;
+        recorded = 0;
+        pending = 0.f;
+        gathered = 0;
+    }
+
+    /** Lanes in `mask` from a unit vector, out of every invariant plane of the systems */
+    void restart(float_4 mask) {
+        const float u = 0.57735027f;
+        v = select(mask, Vec3<float_4>{u, u, u}, v);
+        time = simd::ifelse(mask, 0.f, time);
+    }
+
+    /** Time dt along the solution from s0 to s1, the lanes in resetMask starting again from
+    where they were reset. Only kept until update().
+    */
+    void record(const Vec3<float_4>& s0, const Vec3<float_4>& s1, const float_4* k, float_4 dt, float_4 resetMask) {
+        if (recorded == LYAPUNOV_PATH)
+            follow();
+        Sample& p = path[recorded++];
+        p.s0 = s0;
+        p.s1 = s1;
+        for (int i = 0; i < System::NUM_COEFFS; i++)
+            p.k[i] = k[i];
+        p.dt = dt;
+        p.resetMask = resetMask;
+    }
+
+    /** At control rate: the tangent along the recorded samples, then renormalized */
+    void update() {
+        follow();
+        renormalize();
+    }
+
+    void follow() {
+        for (int i = 0; i < recorded; i++)
+            step(path[i].s0, path[i].s1, path[i].k, path[i].dt, path[i].resetMask);
+        recorded = 0;
+    }
+
+    void step(const Vec3<float_4>& s0, const Vec3<float_4>& s1, const float_4* k, float_4 dt, float_4 resetMask) {
+        float longest = hmax(dt);
+        bool reset = simd::movemask(resetMask);
+        if (gathered > 0 || 2.f * longest <= System::TANGENT_STEP) {
+            if (gathered == 0)
+                gather = (longest * LYAPUNOV_GATHER_MAX > System::TANGENT_STEP) ? (int) (System::TANGENT_STEP / longest) : LYAPUNOV_GATHER_MAX;
+            pending += dt;
+            gathered++;
+            if (gathered == gather / 2)
+                middle = s1;
+            // A reset ends the step early, at the state reached before it
+            if (gathered < gather && !reset && hmax(pending) <= System::TANGENT_STEP)
+                return;
+            if (gathered < gather / 2)
+                middle = reset ? s0 : s1;
+            advance(middle, k, pending);
+            time += pending;
+            pending = 0.f;
+            gathered = 0;
+        }
+        else {
+            int n = (int) std::ceil(longest / System::TANGENT_STEP);
+            float_4 h = dt / (float) n;
+            for (int i = 0; i < n; i++) {
+                float_4 f = (i + 0.5f) / n;
+                advance(Vec3<float_4>{s0.x + f * (s1.x - s0.x), s0.y + f * (s1.y - s0.y), s0.z + f * (s1.z - s0.z)}, k, h);
+            }
+            time += dt;
+        }
+        if (reset)
+            restart(resetMask);
+    }
+
+    /** Tangent over h at the state s, exp(h J) v to the fourth order */
+    void advance(const Vec3<float_4>& s, const float_4* k, float_4 h) {
+        Vec3<float_4> t = v;
+        for (int j = 1; j <= 4; j++) {
+            t = System::tangent(s, t, k);
+            float_4 c = h / (float) j;
+            t = Vec3<float_4>{t.x * c, t.y * c, t.z * c};
+            v = madd(v, float_4(1.f), t);
+        }
+    }
+
+    /** Back to unit length, adding the growth since the last time to the estimate */
+    void renormalize() {
+        float_4 norm2 = v.x * v.x + v.y * v.y + v.z * v.z;
+        // Lost to zero or overflow, from a state far out of the attractor
+        float_4 lost = ~((norm2 > 1e-30f) & (norm2 < 1e30f));
+        float_4 growth = 0.5f * simd::log(simd::ifelse(lost, 1.f, norm2));
+        // A plain mean until the average is full, so the estimate needs no time to rise from 0
+        span = simd::fmin(span + time, LYAPUNOV_PERIODS * System::PERIOD);
+        exponent += simd::ifelse(lost | (span <= 0.f), 0.f, (growth - exponent * time) / span);
+        float_4 scale = 1.f / simd::sqrt(norm2);
+        v = Vec3<float_4>{v.x * scale, v.y * scale, v.z * scale};
+        time = 0.f;
+        restart(lost);
+    }
+
+    /** Exponent in nats per period of the system, LYAPUNOV_VOLTS to 1 and clamped to +-10 V */
+    float_4 voltage() const {
+        return simd::clamp(LYAPUNOV_VOLTS * System::PERIOD * exponent, -10.f, 10.f);
+    }
+};
@@ -0,0 +1,204 @@
+#pragma once
+#include "Attractor.hpp"
+
+
+/** Several float_4 blocks stepped as one lane type, so that the solvers can run every node of
+a network at once. Each operation is done block by block.
+*/
+template <int B>
+struct NodeVector {
+    simd::float_4 v[B];
+
+    NodeVector() = default;
+    NodeVector(float x) {
+        for (int i = 0; i < B; i++)
+            v[i] = x;
+    }
+};
+
+#define NODE_VECTOR_OPERATOR(op) \
+    template <int B> \
+    inline NodeVector<B> operator op(const NodeVector<B>& a, const NodeVector<B>& b) { \
+        NodeVector<B> r; \
+        for (int i = 0; i < B; i++) \
+            r.v[i] = a.v[i] op b.v[i]; \
+        return r; \
+    } \
+    template <int B> \
+    inline NodeVector<B> operator op(const NodeVector<B>& a, float b) { \
+        NodeVector<B> r; \
+        for (int i = 0; i < B; i++) \
+            r.v[i] = a.v[i] op b; \
+        return r; \
+    } \
+    template <int B> \
+    inline NodeVector<B> operator op(float a, const NodeVector<B>& b) { \
+        NodeVector<B> r; \
+        for (int i = 0; i < B; i++) \
+            r.v[i] = a op b.v[i]; \
+        return r; \
+    }
+
+NODE_VECTOR_OPERATOR(+)
+NODE_VECTOR_OPERATOR(-)
+NODE_VECTOR_OPERATOR(*)
+NODE_VECTOR_OPERATOR(/)
+NODE_VECTOR_OPERATOR(>)
+NODE_VECTOR_OPERATOR(>=)
+NODE_VECTOR_OPERATOR(<)
+NODE_VECTOR_OPERATOR(<=)
+NODE_VECTOR_OPERATOR(|)
+NODE_VECTOR_OPERATOR(&)
+
+#undef NODE_VECTOR_OPERATOR
+
+template <int B>
+inline NodeVector<B> operator-(const NodeVector<B>& a) {
+    NodeVector<B> r;
+    for (int i = 0; i < B; i++)
+        r.v[i] = -a.v[i];
+    return r;
+}
+
+template <int B>
+inline NodeVector<B> abs(const NodeVector<B>& a) {
+    NodeVector<B> r;
+    for (int i = 0; i < B; i++)
+        r.v[i] = simd::abs(a.v[i]);
+    return r;
+}
+
+template <int B>
+inline NodeVector<B> select(const NodeVector<B>& mask, const NodeVector<B>& a, const NodeVector<B>& b) {
+    NodeVector<B> r;
+    for (int i = 0; i < B; i++)
+        r.v[i] = simd::ifelse(mask.v[i], a.v[i], b.v[i]);
+    return r;
+}
+
+template <>
+struct LaneType<8> {
+    typedef NodeVector<2> type;
+    typedef NodeVector<2> mask;
+};
+
+template <>
+struct LaneType<12> {
+    typedef NodeVector<3> type;
+    typedef NodeVector<3> mask;
+};
+
+template <>
+struct LaneType<16> {
+    typedef NodeVector<4> type;
+    typedef NodeVector<4> mask;
+};
+
+/** Blocks of a lane type, a single float_4 for up to 4 nodes */
+template <typename T>
+struct NodeTraits;
+
+template <>
+struct NodeTraits<simd::float_4> {
+    static constexpr int BLOCKS = 1;
+};
+
+template <int B>
+struct NodeTraits<NodeVector<B>> {
+    static constexpr int BLOCKS = B;
+};
+
+inline simd::float_4& block(simd::float_4& v, int b) {
+    return v;
+}
+
+inline const simd::float_4& block(const simd::float_4& v, int b) {
+    return v;
+}
+
+template <int B>
+inline simd::float_4& block(NodeVector<B>& v, int b) {
+    return v.v[b];
+}
+
+template <int B>
+inline const simd::float_4& block(const NodeVector<B>& v, int b) {
+    return v.v[b];
+}
+
+/** Value of node `i` */
+template <typename T>
+inline float lane(const T& v, int i) {
+    return block(v, i / 4)[i % 4];
+}
+
+/** 0, 1, 2... along the nodes */
+template <typename T>
+inline T laneIndex() {
+    T r;
+    for (int b = 0; b < NodeTraits<T>::BLOCKS; b++)
+        block(r, b) = simd::float_4(0.f, 1.f, 2.f, 3.f) + 4.f * b;
+    return r;
+}
+
+/** Copies the first blocks of every node of `src` into `dst`, or back with `store` */
+template <typename T, int B>
+inline void loadNodes(AttractorState<T>& dst, const AttractorState<NodeVector<B>>& src) {
+    for (int b = 0; b < NodeTraits<T>::BLOCKS; b++) {
+        block(dst.s.x, b) = src.s.x.v[b];
+        block(dst.s.y, b) = src.s.y.v[b];
+        block(dst.s.z, b) = src.s.z.v[b];
+        block(dst.preDC.x, b) = src.preDC.x.v[b];
+        block(dst.preDC.y, b) = src.preDC.y.v[b];
+        block(dst.preDC.z, b) = src.preDC.z.v[b];
+        block(dst.postDC.x, b) = src.postDC.x.v[b];
+        block(dst.postDC.y, b) = src.postDC.y.v[b];
+        block(dst.postDC.z, b) = src.postDC.z.v[b];
+    }
+}
+
+template <typename T, int B>
+inline void storeNodes(AttractorState<NodeVector<B>>& dst, const AttractorState<T>& src) {
+    for (int b = 0; b < NodeTraits<T>::BLOCKS; b++) {
+        dst.s.x.v[b] = block(src.s.x, b);
+        dst.s.y.v[b] = block(src.s.y, b);
+        dst.s.z.v[b] = block(src.s.z, b);
+        dst.preDC.x.v[b] = block(src.preDC.x, b);
+        dst.preDC.y.v[b] = block(src.preDC.y, b);
+        dst.preDC.z.v[b] = block(src.preDC.z, b);
+        dst.postDC.x.v[b] = block(src.postDC.x, b);
+        dst.postDC.y.v[b] = block(src.postDC.y, b);
+        dst.postDC.z.v[b] = block(src.postDC.z, b);
+    }
+}
+
+
+/** Network of nodes following `System`, each one pulled on x towards the mean of the nodes
+it is linked to (diffusive coupling). It solves as a System itself, one node per lane.
+
+The coefficients after the ones of `System` are the coupling strength of each node, at
+NUM_COEFFS, and the columns of the weights matrix: the weight of node j in the mean of every
+node is at NUM_COEFFS + 1 + j. The means of all nodes are then one product per node and block.
+`System` also supplies COUPLING_MAX, the coupling at full knob.
+*/
+template <class System>
+struct Coupled : System {
+    template <typename T>
+    static Vec3<T> derive(const Vec3<T>& s, const T* k) {
+        Vec3<T> d = System::derive(s, k);
+        const T* w = k + System::NUM_COEFFS + 1;
+        T mean = w[0] * T(lane(s.x, 0));
+        for (int j = 1; j < 4 * NodeTraits<T>::BLOCKS; j++)
+            mean = mean + w[j] * T(lane(s.x, j));
+        d.x = d.x + k[System::NUM_COEFFS] * (mean - s.x);
+        return d;
+    }
+
+    /** Initial conditions slightly apart, or identical nodes would stay in sync forever */
+    template <typename T>
+    static Vec3<T> initial() {
+        Vec3<T> s = System::template initial<T>();
+        s.x = s.x + 0.01f * laneIndex<T>();
+        return s;
+    }
+};
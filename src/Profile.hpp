@@ -0,0 +1,196 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+// Instrumentation of process(), compiled in by `make PROFILE=1`, which defines CHAOS_PROFILE,
+// and then turned on per module from its menu. Without the flag the PROFILE_ macros are
+// empty and the modules carry no counters.
+
+// Samples per timed sample, prime so that timed samples fall on every phase of the control
+// rate dividers
+static const int PROFILE_INTERVAL = 61;
+
+
+/** Counters of one module. Only the audio thread writes them, with plain loads and stores
+instead of locked instructions, and the UI thread reads them at any time.
+*/
+struct ProfileCounters {
+    enum Section {
+        SECTION_PROCESS,
+        SECTION_OUTPUT,     // DC blockers and the output stage
+        SECTIONS_LEN
+    };
+
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> timed[SECTIONS_LEN];
+    std::atomic<uint64_t> ns[SECTIONS_LEN];
+    std::atomic<uint64_t> voiceSamples{0};
+    std::atomic<uint64_t> steps{0};             // integration steps, summed over the voices
+    std::atomic<uint64_t> divergenceResets{0};  // voices, not samples
+    std::atomic<uint64_t> triggerResets{0};
+    // Set by the UI thread, the audio thread clears the counters
+    std::atomic<bool> clearRequest{false};
+
+    // Counters of the module being timed on this thread, during timed samples only
+    static thread_local ProfileCounters* timing;
+
+    ProfileCounters() {
+        clear();
+        // Measured here rather than on the audio thread
+        clockOverhead();
+    }
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /** Time measured between two reads of the clock with nothing in between */
+    static uint64_t clockOverhead() {
+        static const uint64_t overhead = []() {
+            uint64_t best = UINT64_MAX;
+            for (int i = 0; i < 64; i++) {
+                uint64_t t0 = now();
+                best = std::min(best, now() - t0);
+            }
+            return best;
+        }();
+        return overhead;
+    }
+
+    /** Adds the time since `start` to a section */
+    void addTime(int section, uint64_t start) {
+        uint64_t t = now() - start;
+        add(ns[section], t - std::min(t, clockOverhead()));
+    }
+
+    void clear() {
+        samples = 0;
+        for (int i = 0; i < SECTIONS_LEN; i++) {
+            timed[i] = 0;
+            ns[i] = 0;
+        }
+        voiceSamples = 0;
+        steps = 0;
+        divergenceResets = 0;
+        triggerResets = 0;
+    }
+
+    double nsPerSample(int section = SECTION_PROCESS) const {
+        return timed[section] ? (double) ns[section] / timed[section] : 0.0;
+    }
+
+    double outputShare() const {
+        double total = nsPerSample();
+        return total > 0.0 ? std::min(nsPerSample(SECTION_OUTPUT) / total, 1.0) : 0.0;
+    }
+
+    double stepsPerVoiceSample() const {
+        return voiceSamples ? (double) steps / voiceSamples : 0.0;
+    }
+
+    json_t* toJson() const {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "samples", json_integer(samples));
+        json_object_set_new(rootJ, "timedSamples", json_integer(timed[SECTION_PROCESS] + timed[SECTION_OUTPUT]));
+        json_object_set_new(rootJ, "nsPerSample", json_real(nsPerSample()));
+        json_object_set_new(rootJ, "outputShare", json_real(outputShare()));
+        json_object_set_new(rootJ, "stepsPerVoiceSample", json_real(stepsPerVoiceSample()));
+        json_object_set_new(rootJ, "divergenceResets", json_integer(divergenceResets));
+        json_object_set_new(rootJ, "triggerResets", json_integer(triggerResets));
+        return rootJ;
+    }
+};
+
+
+/** One sample of process(), counted, and once every PROFILE_INTERVAL samples timed: in turns
+the whole sample or its sections, so that the clock reads of the sections do not add to the
+time of the whole. Reading the clock costs about as much as a voice of Euler, so timing
+every sample would distort what it measures.
+*/
+struct ProfileSample {
+    ProfileCounters* counters = nullptr;
+    ProfileCounters* sections = nullptr;
+    uint64_t start;
+
+    explicit ProfileSample(ProfileCounters* c) {
+        if (!c)
+            return;
+        if (c->clearRequest.load(std::memory_order_relaxed)) {
+            c->clear();
+            c->clearRequest = false;
+        }
+        uint64_t n = c->samples.load(std::memory_order_relaxed);
+        ProfileCounters::add(c->samples, 1);
+        if (n % PROFILE_INTERVAL != 0)
+            return;
+        if (n / PROFILE_INTERVAL % 2) {
+            sections = c;
+            ProfileCounters::timing = c;
+        }
+        else {
+            counters = c;
+            start = ProfileCounters::now();
+        }
+    }
+
+    ~ProfileSample() {
+        if (counters) {
+            counters->addTime(ProfileCounters::SECTION_PROCESS, start);
+            ProfileCounters::add(counters->timed[ProfileCounters::SECTION_PROCESS], 1);
+        }
+        if (sections) {
+            ProfileCounters::add(sections->timed[ProfileCounters::SECTION_OUTPUT], 1);
+            ProfileCounters::timing = nullptr;
+        }
+    }
+};
+
+/** Time of the enclosing scope added to a section, in timed samples */
+struct ProfileSection {
+    ProfileCounters* counters;
+    int section;
+    uint64_t start;
+
+    explicit ProfileSection(int section) : counters(ProfileCounters::timing), section(section) {
+        if (counters)
+            start = ProfileCounters::now();
+    }
+
+    ~ProfileSection() {
+        if (counters)
+            counters->addTime(section, start);
+    }
+};
+
+
+#ifdef CHAOS_PROFILE
+#define PROFILE_SAMPLE(counters) ProfileSample profileSample(counters)
+#define PROFILE_SECTION(section) ProfileSection profileSection(ProfileCounters::section)
+#define PROFILE_COUNT(counters, counter, n) do { if (counters) ProfileCounters::add((counters)->counter, n); } while (0)
+#else
+#define PROFILE_SAMPLE(counters)
+#define PROFILE_SECTION(section)
+#define PROFILE_COUNT(counters, counter, n)
+#endif
+
+
+/** Menu entries of the profiler: the toggle, and what it measured so far */
+inline void appendProfileMenu(Menu* menu, bool* profiling, ProfileCounters* counters) {
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createBoolPtrMenuItem("Profile process()", "", profiling));
+    if (!*profiling)
+        return;
+    menu->addChild(createMenuLabel(string::f("%.0f ns per sample, %.0f%% in DC blockers and outputs", counters->nsPerSample(), 100.0 * counters->outputShare())));
+    menu->addChild(createMenuLabel(string::f("%.2f steps per voice and sample", counters->stepsPerVoiceSample())));
+    menu->addChild(createMenuLabel(string::f("%llu divergence resets, %llu Reset input resets", (unsigned long long) counters->divergenceResets, (unsigned long long) counters->triggerResets)));
+    menu->addChild(createMenuItem("Clear", "", [=]() {
+        counters->clearRequest = true;
+    }));
+}
@@ -0,0 +1,253 @@
+#include "Recorder.hpp"
+#include <osdialog.h>
+#include <chrono>
+#if defined ARCH_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// Bytes mapped at a time, a multiple of the 64 KiB that Windows maps by
+static const uint64_t RECORD_WINDOW = 16 << 20;
+// Between two looks of the writer at the full chunks, a small part of the chunks in between
+static const int RECORD_POLL_MS = 10;
+
+
+#if defined ARCH_WIN
+
+struct MappedFile::Handle {
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    uint8_t* window = nullptr;
+    uint64_t start = 0;
+    uint64_t length = 0;    // of the file on disk
+
+    bool resize(uint64_t bytes) {
+        LARGE_INTEGER n;
+        n.QuadPart = bytes;
+        if (!SetFilePointerEx(file, n, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+            return false;
+        length = bytes;
+        return true;
+    }
+
+    /** Only ever grows the file, mapping back an earlier window keeps what follows it */
+    bool map(uint64_t offset) {
+        unmap();
+        uint64_t end = offset + RECORD_WINDOW;
+        if (end > length && !resize(end))
+            return false;
+        mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, end >> 32, end & 0xffffffff, NULL);
+        if (!mapping)
+            return false;
+        window = (uint8_t*) MapViewOfFile(mapping, FILE_MAP_WRITE, offset >> 32, offset & 0xffffffff, RECORD_WINDOW);
+        start = offset;
+        return window != nullptr;
+    }
+
+    void unmap() {
+        if (window)
+            UnmapViewOfFile(window);
+        if (mapping)
+            CloseHandle(mapping);
+        window = nullptr;
+        mapping = NULL;
+    }
+};
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int n = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+    std::wstring pathW(n, 0);
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &pathW[0], n);
+    HANDLE file = CreateFileW(pathW.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    handle = new Handle;
+    handle->file = file;
+    size = 0;
+    return true;
+}
+
+void MappedFile::close(const void* header, uint64_t bytes) {
+    if (!handle)
+        return;
+    if (header && handle->map(0))
+        std::memcpy(handle->window, header, bytes);
+    handle->unmap();
+    handle->resize(size);
+    CloseHandle(handle->file);
+    delete handle;
+    handle = nullptr;
+}
+
+#else
+
+struct MappedFile::Handle {
+    int fd = -1;
+    uint8_t* window = nullptr;
+    uint64_t start = 0;
+    uint64_t length = 0;    // of the file on disk
+
+    bool resize(uint64_t bytes) {
+        if (ftruncate(fd, bytes) != 0)
+            return false;
+        length = bytes;
+        return true;
+    }
+
+    /** Only ever grows the file, mapping back an earlier window keeps what follows it */
+    bool map(uint64_t offset) {
+        unmap();
+        uint64_t end = offset + RECORD_WINDOW;
+        if (end > length && !resize(end))
+            return false;
+        void* p = mmap(nullptr, RECORD_WINDOW, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+        if (p == MAP_FAILED)
+            return false;
+        window = (uint8_t*) p;
+        start = offset;
+        return true;
+    }
+
+    void unmap() {
+        if (window)
+            munmap(window, RECORD_WINDOW);
+        window = nullptr;
+    }
+};
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    handle = new Handle;
+    handle->fd = fd;
+    size = 0;
+    return true;
+}
+
+void MappedFile::close(const void* header, uint64_t bytes) {
+    if (!handle)
+        return;
+    if (header && handle->map(0))
+        std::memcpy(handle->window, header, bytes);
+    handle->unmap();
+    handle->resize(size);
+    ::close(handle->fd);
+    delete handle;
+    handle = nullptr;
+}
+
+#endif
+
+bool MappedFile::write(const void* data, uint64_t bytes) {
+    const uint8_t* p = (const uint8_t*) data;
+    while (bytes > 0) {
+        if (!handle->window || size >= handle->start + RECORD_WINDOW) {
+            if (!handle->map(size - size % RECORD_WINDOW))
+                return false;
+        }
+        uint64_t n = std::min(bytes, handle->start + RECORD_WINDOW - size);
+        std::memcpy(handle->window + (size - handle->start), p, n);
+        size += n;
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+
+bool TrajectoryRecorder::start(const std::string& path, const RecordHeader& h) {
+    stop();
+    failed = !file.open(path);
+    if (failed)
+        return false;
+    header = h;
+    floatsPerFrame = 3 * h.channels;
+    int chunks = clamp((int) std::ceil(RECORD_BUFFER_SECONDS * h.sampleRate / RECORD_CHUNK_FRAMES), 4, RECORD_MAX_CHUNKS);
+    // Written here, so that the audio thread never touches a page for the first time
+    memory.assign((size_t) chunks * RECORD_CHUNK_FRAMES * floatsPerFrame, 0.f);
+    int c;
+    while (freeChunks.pop(c)) {}
+    for (c = 0; c < chunks; c++)
+        freeChunks.push(c);
+    chunk = -1;
+    frames = 0;
+    dropped = 0;
+    finishing = false;
+
+    // A recording cut short still starts with its header
+    file.write(&header, sizeof(header));
+    writer = std::thread([this]() {
+        write();
+    });
+    active = true;
+    return true;
+}
+
+
+void TrajectoryRecorder::stop() {
+    if (!writer.joinable())
+        return;
+    active = false;
+    while (busy)
+        std::this_thread::yield();
+    // The audio thread is out, its last chunk goes to the writer from here
+    if (chunk >= 0 && filled > 0)
+        fullChunks.push(RecordChunk{chunk, filled});
+    chunk = -1;
+    finishing.store(true, std::memory_order_release);
+    writer.join();
+
+    header.frames = (file.size - sizeof(header)) / (floatsPerFrame * sizeof(float));
+    file.close(&header, sizeof(header));
+    std::vector<float>().swap(memory);
+}
+
+
+void TrajectoryRecorder::write() {
+    while (true) {
+        bool last = finishing.load(std::memory_order_acquire);
+        bool any = false;
+        RecordChunk c;
+        while (fullChunks.pop(c)) {
+            if (!failed && !file.write(&memory[(size_t) c.index * RECORD_CHUNK_FRAMES * floatsPerFrame], (uint64_t) c.frames * floatsPerFrame * sizeof(float)))
+                failed = true;
+            freeChunks.push(c.index);
+            any = true;
+        }
+        if (last)
+            break;
+        if (!any)
+            std::this_thread::sleep_for(std::chrono::milliseconds(RECORD_POLL_MS));
+    }
+}
+
+
+void appendRecordMenu(Menu* menu, Recordable* module) {
+    TrajectoryRecorder* recorder = &module->recorder;
+    menu->addChild(new MenuSeparator);
+    if (!recorder->isRecording()) {
+        menu->addChild(createMenuItem("Record trajectory...", "", [=]() {
+            osdialog_filters* filters = osdialog_filters_parse("Trajectory:traj");
+            char* path = osdialog_file(OSDIALOG_SAVE, NULL, "trajectory.traj", filters);
+            osdialog_filters_free(filters);
+            if (!path)
+                return;
+            recorder->start(path, module->recordHeader());
+            std::free(path);
+        }));
+        if (recorder->failed)
+            menu->addChild(createMenuLabel("The last recording could not be written"));
+        return;
+    }
+    menu->addChild(createMenuLabel(string::f("Recording %d voices, %.1f s, %llu frames dropped", (int) recorder->header.channels, recorder->seconds(), (unsigned long long) recorder->dropped)));
+    menu->addChild(createMenuItem("Stop recording", "", [=]() {
+        recorder->stop();
+    }));
+}
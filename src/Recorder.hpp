@@ -0,0 +1,149 @@
+#pragma once
+#include "Attractor.hpp"
+#include "Scope.hpp"
+#include <thread>
+
+
+// Record mode: the x/y/z state of every voice, as it enters the DC blockers, at the full
+// sample rate. The audio thread fills preallocated chunks and hands them over through wait-free
+// rings, and a writer thread streams them into a memory-mapped file. The audio thread never
+// allocates, locks or calls the system; when the writer falls behind it drops frames and
+// counts them.
+
+static const int RECORD_CHUNK_FRAMES = 4096;
+static const int RECORD_MAX_CHUNKS = 256;
+static const float RECORD_BUFFER_SECONDS = 1.f;    // of chunks between the threads
+static const int RECORD_PARAMS = 16;
+
+
+/** Start of a recording file, little-endian, followed by `frames` frames of `channels` x, y, z
+float triples
+*/
+struct RecordHeader {
+    char magic[8] = {'J', 'C', 'T', 'R', 'A', 'J', 0, 0};
+    uint32_t version = 1;
+    uint32_t headerSize = sizeof(RecordHeader);
+    char system[24] = {};       // model slug
+    float sampleRate = 0.f;
+    uint32_t channels = 0;
+    uint64_t frames = 0;        // written when the recording stops
+    int32_t integrator = 0;
+    int32_t quality = 0;
+    float params[RECORD_PARAMS] = {};   // panel at the start, in the order of the ParamIds
+};
+
+static_assert(sizeof(RecordHeader) == 128, "RecordHeader is part of the file format");
+
+
+/** File written through a window mapped in memory, moved along as it fills, see Recorder.cpp */
+struct MappedFile {
+    struct Handle;
+    Handle* handle = nullptr;
+    uint64_t size = 0;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& path);
+    bool write(const void* data, uint64_t bytes);
+    /** Rewrites the first `bytes` of the file, cuts it at `size` and closes it */
+    void close(const void* header = nullptr, uint64_t bytes = 0);
+};
+
+
+struct RecordChunk {
+    int index;
+    int frames;
+};
+
+
+struct TrajectoryRecorder {
+    // Audio thread
+    std::atomic<bool> active{false};
+    std::atomic<bool> busy{false};
+    int chunk = -1;
+    int filled = 0;
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> dropped{0};
+
+    // Set at start
+    RecordHeader header;
+    int floatsPerFrame = 0;
+    std::vector<float> memory;
+    SpscRing<int, RECORD_MAX_CHUNKS> freeChunks;            // writer to audio thread
+    SpscRing<RecordChunk, RECORD_MAX_CHUNKS> fullChunks;    // audio thread to writer
+    MappedFile file;
+    std::thread writer;
+    std::atomic<bool> finishing{false};
+    std::atomic<bool> failed{false};
+
+    ~TrajectoryRecorder() {
+        stop();
+    }
+
+    /** UI thread: opens `path` and starts recording the first `h.channels` voices. False
+    when the file cannot be written.
+    */
+    bool start(const std::string& path, const RecordHeader& h);
+    /** UI thread: writes what is left and closes the file, with or without the audio thread */
+    void stop();
+
+    bool isRecording() const {
+        return writer.joinable();
+    }
+
+    double seconds() const {
+        return header.sampleRate > 0.f ? frames / header.sampleRate : 0.0;
+    }
+
+    /** Audio thread: one frame, `block(b)` giving the Vec3<float_4> of voices 4b to 4b + 3 */
+    template <typename Block>
+    void push(Block block) {
+        if (!active.load(std::memory_order_relaxed))
+            return;
+        // With stop(), which clears active and then waits for busy to clear
+        busy.store(true);
+        if (active.load()) {
+            if (chunk < 0 && freeChunks.pop(chunk))
+                filled = 0;
+            if (chunk < 0) {
+                ProfileCounters::add(dropped, 1);
+            }
+            else {
+                float* frame = &memory[((size_t) chunk * RECORD_CHUNK_FRAMES + filled) * floatsPerFrame];
+                for (int c = 0; c < (int) header.channels; c += 4) {
+                    const Vec3<simd::float_4> s = block(c / 4);
+                    for (int i = 0; i < std::min((int) header.channels - c, 4); i++) {
+                        frame[3 * (c + i)] = s.x[i];
+                        frame[3 * (c + i) + 1] = s.y[i];
+                        frame[3 * (c + i) + 2] = s.z[i];
+                    }
+                }
+                ProfileCounters::add(frames, 1);
+                if (++filled == RECORD_CHUNK_FRAMES) {
+                    fullChunks.push(RecordChunk{chunk, filled});
+                    chunk = -1;
+                }
+            }
+        }
+        busy.store(false, std::memory_order_release);
+    }
+
+    /** Writer thread */
+    void write();
+};
+
+
+/** Module with a record mode */
+struct Recordable {
+    TrajectoryRecorder recorder;
+
+    virtual ~Recordable() {}
+    /** What the module is playing, for a recording starting now */
+    virtual RecordHeader recordHeader() = 0;
+};
+
+
+/** Menu entries of record mode */
+void appendRecordMenu(Menu* menu, Recordable* module);
@@ -0,0 +1,173 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+
+
+/** Wait-free ring buffer for a single producer and a single consumer thread.
+The producer drops new items when it is full instead of waiting.
+*/
+template <typename T, int N>
+struct SpscRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of 2");
+    T data[N];
+    std::atomic<uint32_t> head{0};   // written by the producer
+    std::atomic<uint32_t> tail{0};   // written by the consumer
+
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= (uint32_t) N)
+            return false;
+        data[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        item = data[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+
+static const int SCOPE_RING_LEN = 1024;
+static const int SCOPE_TRACE_LEN = 1024;
+static const float SCOPE_FPS = 30.f;
+
+
+struct ScopePoint {
+    float x, y, z;
+};
+
+
+/** Audio side of the phase-space scope: the outputs of the first voice, decimated */
+struct ScopeBuffer {
+    SpscRing<ScopePoint, SCOPE_RING_LEN> ring;
+    dsp::ClockDivider divider;
+
+    /** Points per second, a few cycles in HF and a few seconds in LF */
+    void setRate(float sampleRate, bool lf) {
+        float pointRate = lf ? 256.f : 12000.f;
+        divider.setDivision(std::max(1, (int) std::lround(sampleRate / pointRate)));
+    }
+
+    void process(float x, float y, float z) {
+        if (divider.process())
+            ring.push(ScopePoint{x, y, z});
+    }
+};
+
+
+/** Phase portrait of the x/y/z trajectory, slowly turning around the vertical axis.
+It only drains the ring and redraws its framebuffer at SCOPE_FPS, whatever the UI frame rate.
+*/
+struct PhaseScope : widget::FramebufferWidget {
+    struct Display : widget::Widget {
+        ScopeBuffer* buffer = nullptr;
+        ScopePoint trace[SCOPE_TRACE_LEN];
+        int tracePos = 0;
+        int traceLen = 0;
+        float extent = 1.f;
+        float angle = 0.f;
+
+        /** Moves the new points of the ring into the trace, returns whether there were any */
+        bool update(float dt) {
+            bool changed = false;
+            ScopePoint p;
+            while (buffer && buffer->ring.pop(p)) {
+                trace[tracePos] = p;
+                tracePos = (tracePos + 1) % SCOPE_TRACE_LEN;
+                traceLen = std::min(traceLen + 1, SCOPE_TRACE_LEN);
+                changed = true;
+            }
+            if (!changed)
+                return false;
+
+            // Scale follows the trajectory, quickly up and slowly down
+            float m = 1e-3f;
+            for (int i = 0; i < traceLen; i++)
+                m = std::max(m, std::max(std::fabs(trace[i].x), std::max(std::fabs(trace[i].y), std::fabs(trace[i].z))));
+            extent = (m > extent) ? m : extent + (m - extent) * std::min(1.f, dt);
+            angle = std::fmod(angle + 0.3f * dt, 2.f * M_PI);
+            return true;
+        }
+
+        void draw(const DrawArgs& args) override {
+            nvgBeginPath(args.vg);
+            nvgRoundedRect(args.vg, 0.f, 0.f, box.size.x, box.size.y, 2.f);
+            nvgFillColor(args.vg, nvgRGB(0x10, 0x10, 0x14));
+            nvgFill(args.vg);
+            if (traceLen < 2)
+                return;
+
+            // Orthographic projection, turned by `angle` and tilted a fixed 0.4 rad
+            float ca = std::cos(angle), sa = std::sin(angle);
+            const float ct = 0.921f, st = 0.389f;
+            float scale = 0.5f * std::min(box.size.x, box.size.y) / (1.1f * extent);
+            float cx = 0.5f * box.size.x, cy = 0.5f * box.size.y;
+
+            nvgScissor(args.vg, 0.f, 0.f, box.size.x, box.size.y);
+            nvgLineCap(args.vg, NVG_ROUND);
+            nvgLineJoin(args.vg, NVG_ROUND);
+            nvgStrokeWidth(args.vg, 0.8f);
+            // Older points fade out, one path per segment of the trace
+            const int SEGMENTS = 8;
+            int start = (tracePos - traceLen + SCOPE_TRACE_LEN) % SCOPE_TRACE_LEN;
+            for (int s = 0; s < SEGMENTS; s++) {
+                int i0 = s * (traceLen - 1) / SEGMENTS;
+                int i1 = (s + 1) * (traceLen - 1) / SEGMENTS;
+                nvgBeginPath(args.vg);
+                for (int i = i0; i <= i1; i++) {
+                    const ScopePoint& p = trace[(start + i) % SCOPE_TRACE_LEN];
+                    float u = ca * p.x + sa * p.z;
+                    float w = -sa * p.x + ca * p.z;
+                    float v = ct * p.y - st * w;
+                    float px = cx + scale * u;
+                    float py = cy - scale * v;
+                    if (i == i0)
+                        nvgMoveTo(args.vg, px, py);
+                    else
+                        nvgLineTo(args.vg, px, py);
+                }
+                nvgStrokeColor(args.vg, nvgRGBAf(0.4f, 0.85f, 1.f, (s + 1.f) / SEGMENTS));
+                nvgStroke(args.vg);
+            }
+            nvgResetScissor(args.vg);
+        }
+    };
+
+    Display* display;
+    float elapsed = 0.f;
+
+    PhaseScope() {
+        display = new Display;
+        addChild(display);
+    }
+
+    void step() override {
+        // Throttled redraw, the framebuffer is reused between updates
+        float dt = APP->window->getLastFrameDuration();
+        elapsed += dt;
+        if (elapsed >= 1.f / SCOPE_FPS) {
+            display->box.size = box.size;
+            if (display->update(elapsed))
+                setDirty();
+            elapsed = 0.f;
+        }
+        FramebufferWidget::step();
+    }
+};
+
+
+/** Scope over the panel area `pos`, `size` in mm, fed by `buffer`, which is null in the browser */
+inline PhaseScope* createPhaseScope(math::Vec pos, math::Vec size, ScopeBuffer* buffer) {
+    PhaseScope* scope = new PhaseScope;
+    scope->box.pos = mm2px(pos);
+    scope->box.size = mm2px(size);
+    scope->display->box.size = scope->box.size;
+    scope->display->buffer = buffer;
+    return scope;
+}
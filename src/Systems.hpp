@@ -0,0 +1,199 @@
+#pragma once
+#include "Attractor.hpp"
+#include "StabilityMap.hpp"
+#include "WarmStates.hpp"
+
+
+struct Chua {
+    enum Coeff { C1, C2, C3, M0, M1, NUM_COEFFS };
+
+    static constexpr float RATE_HF = 800.f;     // rate 0 a 800 /sr
+    static constexpr float RATE_LF = 100.f;
+    static constexpr int SUBSTEPS_HF = 6;
+    static constexpr float TANGENT_STEP = 0.025f;  // longest step of the chaos meter, short for the corners of h
+    static constexpr float COUPLING_MAX = 30.f;    // cluster coupling at full knob
+    static constexpr float PERIOD = 1.2855f;       // mean period of x at the default knobs
+
+    static constexpr ParamMap paramMap(int i) {
+        return i == C1 ? ParamMap{2, 0.1f, 15.6f, 0.04f, 15.6f, 15.7f}              // C1 15.6 a 15.7
+            : i == C2 ? ParamMap{0, 1.1f, 0.98f, 0.5f, 0.98f, 1.9f}                 // C2 0.98 a 1.9
+            : i == C3 ? ParamMap{2, 0.6f, 27.9f, 0.25f, 27.6f, 28.5f}               // C3 27.6 a 28.5
+            : i == M0 ? ParamMap{1, -0.087f, -1.143f, -0.04f, -1.23f, -1.143f}      // m0 -1.143 a -1.23
+            : ParamMap{2, -0.046f, -0.754f, -0.02f, -0.8f, -0.754f};                // m1 -0.754 a -0.8
+    }
+
+    static const uint16_t* stabilityMap() {
+        return chuaStability;
+    }
+
+    static const float* warmStates(bool lf) {
+        return lf ? chuaWarmStatesLF : chuaWarmStatesHF;
+    }
+
+    static const char* paramName(int i) {
+        return i == 0 ? "P1" : i == 1 ? "P2" : "P3";
+    }
+
+    template <typename T>
+    static Vec3<T> derive(const Vec3<T>& s, const T* k) {
+        using namespace simd;
+        T h = s.x*k[M1]+(k[M0]-k[M1])*0.5f*(abs(s.x+1.f)-abs(s.x-1.f));
+        return Vec3<T>{
+            k[C1]*(s.y-s.x-h),
+            k[C2]*(s.x-s.y+s.z),
+            -k[C3]*s.y
+        };
+    }
+
+    /** Jacobian at s times v, for the chaos meter */
+    template <typename T>
+    static Vec3<T> tangent(const Vec3<T>& s, const Vec3<T>& v, const T* k) {
+        using namespace simd;
+        T slope = select(abs(s.x) < 1.f, k[M0], k[M1]);
+        return Vec3<T>{
+            k[C1]*(v.y-v.x-slope*v.x),
+            k[C2]*(v.x-v.y+v.z),
+            -k[C3]*v.y
+        };
+    }
+
+    template <typename T>
+    static Vec3<T> initial() {
+        return Vec3<T>{0.1f, 0.f, 0.f};
+    }
+
+    static constexpr Vec3<float> clipScale() {
+        return Vec3<float>{1.f, 1.f, 1.f};
+    }
+
+    template <typename T>
+    static Vec3<T> output(const Vec3<T>& dc) {
+        return Vec3<T>{2.5f * dc.x, 8.5f * dc.y, 1.8f * dc.z};
+    }
+};
+
+
+struct Rossler {
+    enum Coeff { A, B, C, NUM_COEFFS };
+
+    static constexpr float RATE_HF = 600.f;     // rate 0 a 600 /sr
+    static constexpr float RATE_LF = 80.f;
+    static constexpr int SUBSTEPS_HF = 7;
+    static constexpr float TANGENT_STEP = 0.1f;    // longest step of the chaos meter
+    static constexpr float COUPLING_MAX = 1.f;    // cluster coupling at full knob
+    static constexpr float PERIOD = 6.2682f;       // mean period of x at the default knobs
+
+    static constexpr ParamMap paramMap(int i) {
+        return i == A ? ParamMap{0, 0.28f, 0.05f, 0.12f, 0.05f, 0.33f}              // A 0.05 a 0.33
+            : i == B ? ParamMap{1, -0.75f, 0.9f, -0.34f, 0.15f, 0.9f}               // B 0.15 a 0.9
+            : ParamMap{2, 11.f, 5.5f, 5.f, 5.5f, 16.5f};                            // C 5.5 a 16.5
+    }
+
+    static const uint16_t* stabilityMap() {
+        return rosslerStability;
+    }
+
+    static const float* warmStates(bool lf) {
+        return lf ? rosslerWarmStatesLF : rosslerWarmStatesHF;
+    }
+
+    static const char* paramName(int i) {
+        return i == 0 ? "A" : i == 1 ? "B" : "C";
+    }
+
+    template <typename T>
+    static Vec3<T> derive(const Vec3<T>& s, const T* k) {
+        return Vec3<T>{
+            -s.y-s.z,
+            s.x+k[A]*s.y,
+            k[B]+s.z*(s.x-k[C])
+        };
+    }
+
+    template <typename T>
+    static Vec3<T> tangent(const Vec3<T>& s, const Vec3<T>& v, const T* k) {
+        return Vec3<T>{
+            -v.y-v.z,
+            v.x+k[A]*v.y,
+            s.z*v.x+(s.x-k[C])*v.z
+        };
+    }
+
+    template <typename T>
+    static Vec3<T> initial() {
+        return Vec3<T>{0.1f, 0.3f, 0.9f};
+    }
+
+    static constexpr Vec3<float> clipScale() {
+        return Vec3<float>{0.19f, 0.19f, 0.019f};
+    }
+
+    template <typename T>
+    static Vec3<T> output(const Vec3<T>& dc) {
+        return Vec3<T>{0.2f * dc.x, 0.2f * dc.y, 0.03f * dc.z};
+    }
+};
+
+
+struct Lorentz84 {
+    enum Coeff { a, b, F, G, NUM_COEFFS };
+
+    static constexpr float RATE_HF = 800.f;     // rate 0 a 800 /sr
+    static constexpr float RATE_LF = 100.f;
+    static constexpr int SUBSTEPS_HF = 6;
+    static constexpr float TANGENT_STEP = 0.05f;    // longest step of the chaos meter
+    static constexpr float COUPLING_MAX = 2.f;    // cluster coupling at full knob
+    static constexpr float PERIOD = 4.5998f;       // mean period of x at the default knobs
+
+    static constexpr ParamMap paramMap(int i) {
+        return i == a ? ParamMap{0, 0.f, 0.25f, 0.f, 0.25f, 0.25f}                  // a fixed
+            : i == b ? ParamMap{0, 2.4f, 2.6f, 1.1f, 2.6f, 5.f}                     // b 2.6 a 5
+            : i == F ? ParamMap{1, 2.6f, 7.4f, 1.2f, 7.4f, 10.f}                    // F 7.4 a 10
+            : ParamMap{2, -0.6f, 1.3f, -0.2f, 0.7f, 1.3f};                          // G 1.3 a 0.7
+    }
+
+    static const uint16_t* stabilityMap() {
+        return lorentz84Stability;
+    }
+
+    static const float* warmStates(bool lf) {
+        return lf ? lorentz84WarmStatesLF : lorentz84WarmStatesHF;
+    }
+
+    static const char* paramName(int i) {
+        return i == 0 ? "P1" : i == 1 ? "P2" : "P3";
+    }
+
+    template <typename T>
+    static Vec3<T> derive(const Vec3<T>& s, const T* k) {
+        return Vec3<T>{
+            -s.y*s.y-s.z*s.z-k[a]*s.x+k[a]*k[F],
+            s.x*s.y-k[b]*s.x*s.z-s.y+k[G],
+            k[b]*s.x*s.y+s.x*s.z-s.z
+        };
+    }
+
+    template <typename T>
+    static Vec3<T> tangent(const Vec3<T>& s, const Vec3<T>& v, const T* k) {
+        return Vec3<T>{
+            -k[a]*v.x-2.f*s.y*v.y-2.f*s.z*v.z,
+            (s.y-k[b]*s.z)*v.x+(s.x-1.f)*v.y-k[b]*s.x*v.z,
+            (k[b]*s.y+s.z)*v.x+k[b]*s.x*v.y+(s.x-1.f)*v.z
+        };
+    }
+
+    template <typename T>
+    static Vec3<T> initial() {
+        return Vec3<T>{0.1f, 0.1f, 0.1f};
+    }
+
+    static constexpr Vec3<float> clipScale() {
+        return Vec3<float>{1.f, 1.f, 1.f};
+    }
+
+    // Outputs (cruzados)
+    template <typename T>
+    static Vec3<T> output(const Vec3<T>& dc) {
+        return Vec3<T>{2.5f * dc.z, 2.5f * dc.x, 2.5f * dc.y};
+    }
+};
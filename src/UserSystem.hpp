@@ -0,0 +1,240 @@
+#pragma once
+#include "Expression.hpp"
+#include "WarmStates.hpp"
+#include <sstream>
+
+
+/** Compiled custom attractor, with what the built-in systems have as constants measured
+from a run of its own at the middle of the knobs: the time is scaled so that the mean
+period of the fastest axis is 2 pi, the divergence test is set at 4 times the extent of
+each axis, and the outputs span ±5 V.
+*/
+struct UserProgram {
+    expr::Program code;
+    ParamMap params[3];
+    Vec3<float> clip;
+    Vec3<float> gain;
+    double period = 0.0;    // of the fastest axis, in the time of the equations
+    // Warm start states from the same run, as in WarmStates.hpp
+    float warm[WARM_STATES * 6];
+    std::string error;
+    // Set on the program of a loaded patch, whose voices carry on from the saved state
+    bool keepVoices = false;
+
+    // The run used to measure it, RK4 from the initial conditions, the first quarter left out
+    static constexpr double CALIBRATION_STEP = 0.005;
+    static constexpr int CALIBRATION_STEPS = 40000;
+
+    /** Compiles the derivatives of x, y, z and the definitions of P1 to P3, each one an
+    optional name and the values at both ends of the knob, as in "rho 20 40". False with
+    a message in `error` when the text is wrong or the system diverges.
+    */
+    bool compile(const std::string equations[3], const std::string paramDefs[3]) {
+        static const char* paramNames[3] = {"P1", "P2", "P3"};
+        static const char* equationNames[3] = {"dx/dt", "dy/dt", "dz/dt"};
+        expr::Compiler compiler;
+        for (int i = 0; i < 3; i++) {
+            if (!parseParam(compiler, paramDefs[i], i)) {
+                error = std::string(paramNames[i]) + ": " + error;
+                return false;
+            }
+        }
+        int roots[3];
+        for (int i = 0; i < 3; i++) {
+            roots[i] = compiler.parse(equations[i]);
+            if (roots[i] < 0) {
+                error = std::string(equationNames[i]) + ": " + compiler.error;
+                return false;
+            }
+        }
+        if (!compiler.generate(code, roots, 1.0) || !calibrate()) {
+            if (error.empty())
+                error = compiler.error;
+            return false;
+        }
+        if (!compiler.generate(code, roots, period / (2.0 * M_PI))) {
+            error = compiler.error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    /** "[name] min max", the knob going from min to max */
+    bool parseParam(expr::Compiler& compiler, const std::string& def, int i) {
+        std::istringstream in(def);
+        std::string first;
+        float lo = 0.f, hi = 1.f;
+        if (in >> first) {
+            if (std::isalpha((unsigned char) first[0]) || first[0] == '_') {
+                if (!compiler.addName(first, 3 + i)) {
+                    error = "'" + first + "' is taken";
+                    return false;
+                }
+                in >> lo >> hi;
+            }
+            else {
+                in.str(def);
+                in.clear();
+                in >> lo >> hi;
+            }
+            std::string rest;
+            if (in.fail() || (in >> rest)) {
+                error = "expected a name and two numbers";
+                return false;
+            }
+        }
+        float range = hi - lo;
+        params[i] = ParamMap{i, range, lo, 0.2f * range, std::min(lo, hi), std::max(lo, hi)};
+        return true;
+    }
+
+    bool calibrate() {
+        double k[3];
+        for (int i = 0; i < 3; i++)
+            k[i] = params[i].offset + 0.5 * params[i].scale;
+        Vec3<double> s{0.1, 0.0, 0.0};
+        const double h = CALIBRATION_STEP;
+        const int skip = CALIBRATION_STEPS / 4;
+        std::vector<double> trace[3];
+        double lo[3] = {INFINITY, INFINITY, INFINITY};
+        double hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for (int n = 0; n < CALIBRATION_STEPS; n++) {
+            Vec3<double> d1 = code.run(s, k);
+            Vec3<double> d2 = code.run(madd(s, 0.5 * h, d1), k);
+            Vec3<double> d3 = code.run(madd(s, 0.5 * h, d2), k);
+            Vec3<double> d4 = code.run(madd(s, h, d3), k);
+            s.x += h / 6.0 * (d1.x + 2.0 * (d2.x + d3.x) + d4.x);
+            s.y += h / 6.0 * (d1.y + 2.0 * (d2.y + d3.y) + d4.y);
+            s.z += h / 6.0 * (d1.z + 2.0 * (d2.z + d3.z) + d4.z);
+            if (!(std::fabs(s.x) + std::fabs(s.y) + std::fabs(s.z) < 1e6)) {
+                error = "diverges at the middle of the knobs";
+                return false;
+            }
+            if (n < skip)
+                continue;
+            const double v[3] = {s.x, s.y, s.z};
+            for (int axis = 0; axis < 3; axis++) {
+                trace[axis].push_back(v[axis]);
+                lo[axis] = std::min(lo[axis], v[axis]);
+                hi[axis] = std::max(hi[axis], v[axis]);
+            }
+        }
+
+        // Mean period of the fastest axis, from the upward crossings of its middle with 10%
+        // hysteresis. Settling to a point or drifting slowly, the time is left as it is.
+        period = 2.0 * M_PI;
+        bool found = false;
+        for (int axis = 0; axis < 3; axis++) {
+            double mid = 0.5 * (lo[axis] + hi[axis]);
+            double band = 0.1 * (hi[axis] - lo[axis]);
+            int crossings = 0;
+            int first = 0, last = 0;
+            bool below = false;
+            for (int n = 0; n < (int) trace[axis].size() && band > 1e-6; n++) {
+                double v = trace[axis][n];
+                if (v < mid - band) {
+                    below = true;
+                }
+                else if (below && v > mid + band) {
+                    below = false;
+                    if (crossings++ == 0)
+                        first = n;
+                    last = n;
+                }
+            }
+            if (crossings > 1) {
+                double p = (last - first) * h / (crossings - 1);
+                period = found ? std::min(period, p) : p;
+                found = true;
+            }
+        }
+
+        float extent[3], span[3];
+        for (int axis = 0; axis < 3; axis++) {
+            extent[axis] = std::max(std::max(std::fabs(lo[axis]), std::fabs(hi[axis])), 1e-3);
+            span[axis] = std::max(hi[axis] - lo[axis], 1e-3);
+        }
+        clip = Vec3<float>{3.f / extent[0], 3.f / extent[1], 3.f / extent[2]};
+        gain = Vec3<float>{10.f / span[0], 10.f / span[1], 10.f / span[2]};
+
+        // States evenly spread over the run, each with its offset from the mean
+        double mean[3] = {};
+        for (int axis = 0; axis < 3; axis++) {
+            for (double v : trace[axis])
+                mean[axis] += v;
+            mean[axis] /= trace[axis].size();
+        }
+        for (int i = 0; i < WARM_STATES; i++) {
+            int n = (i + 1) * trace[0].size() / WARM_STATES - 1;
+            for (int axis = 0; axis < 3; axis++) {
+                warm[6 * i + axis] = trace[axis][n];
+                warm[6 * i + 3 + axis] = trace[axis][n] - mean[axis];
+            }
+        }
+        return true;
+    }
+};
+
+
+/** System of the custom attractor module, running the program set for this thread */
+struct UserSystem {
+    enum Coeff { P1, P2, P3, NUM_COEFFS };
+
+    static constexpr float RATE_HF = 600.f;     // same as Rossler, whose period is also about 2 pi
+    static constexpr float RATE_LF = 80.f;
+    static constexpr int SUBSTEPS_HF = 7;
+    static constexpr float TANGENT_STEP = 0.1f;
+    static constexpr float PERIOD = 2.f * M_PI;   // time is scaled to it when compiled
+
+    // Set by the module before each sample, since several of them run on different threads
+    static thread_local const UserProgram* program;
+
+    static ParamMap paramMap(int i) {
+        return program->params[i];
+    }
+
+    static const char* paramName(int i) {
+        return i == 0 ? "P1" : i == 1 ? "P2" : "P3";
+    }
+
+    // Equations are only known at run time, with no map made offline
+    static const uint16_t* stabilityMap() {
+        return nullptr;
+    }
+
+    // From the calibration run in both ranges, null before the module has a program on
+    // this thread
+    static const float* warmStates(bool lf) {
+        return program ? program->warm : nullptr;
+    }
+
+    template <typename T>
+    static Vec3<T> derive(const Vec3<T>& s, const T* k) {
+        return program->code.run(s, k);
+    }
+
+    // Equations without a Jacobian: a finite difference along v, two runs of the program
+    template <typename T>
+    static Vec3<T> tangent(const Vec3<T>& s, const Vec3<T>& v, const T* k) {
+        const float e = 1e-3f;
+        Vec3<T> d0 = program->code.run(s, k);
+        Vec3<T> d1 = program->code.run(madd(s, T(e), v), k);
+        return Vec3<T>{(d1.x - d0.x) * (1.f / e), (d1.y - d0.y) * (1.f / e), (d1.z - d0.z) * (1.f / e)};
+    }
+
+    template <typename T>
+    static Vec3<T> initial() {
+        return Vec3<T>{0.1f, 0.f, 0.f};
+    }
+
+    static Vec3<float> clipScale() {
+        return program->clip;
+    }
+
+    template <typename T>
+    static Vec3<T> output(const Vec3<T>& dc) {
+        const Vec3<float>& g = program->gain;
+        return Vec3<T>{g.x * dc.x, g.y * dc.y, g.z * dc.z};
+    }
+};
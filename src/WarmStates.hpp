@@ -0,0 +1,81 @@
+#pragma once
+
+
+// Generated by `build/sweep --warm-states src/WarmStates.hpp`, see sweep/warm.cpp.
+//
+// States on the attractor of each system and range at the middle of the knobs, which the
+// modules start and reset from instead of the initial conditions. Each entry is x, y, z
+// and the output of a settled DC blocker there, the state minus the mean of the attractor.
+static const int WARM_STATES = 8;
+
+// Chua HF: mean -0.0565124, 0.00087323, 0.0566753
+static constexpr float chuaWarmStatesHF[WARM_STATES * 6] = {
+    -0.88966329f, -0.31117596f, -0.15576286f, -0.83315085f, -0.3120492f, -0.21243812f,
+    -1.096446f, 0.097602402f, 0.17537898f, -1.0399335f, 0.096729171f, 0.11870372f,
+    2.3690683f, 0.18868299f, -2.6053978f, 2.4255808f, 0.18780976f, -2.662073f,
+    -1.8473572f, 0.091013829f, 2.1945861f, -1.7908448f, 0.090140599f, 2.1379109f,
+    -1.741712f, -0.15405144f, 1.0267754f, -1.6851995f, -0.15492467f, 0.97010017f,
+    1.3881472f, -0.10388441f, -2.0421531f, 1.4446596f, -0.10475764f, -2.0988284f,
+    -1.3259119f, 0.020920047f, 0.67610108f, -1.2693994f, 0.020046817f, 0.61942581f,
+    2.3812755f, 0.1273376f, -2.8598531f, 2.437788f, 0.12646437f, -2.9165284f
+};
+
+// Rossler HF: mean 0.175088, -0.959668, 0.946353
+static constexpr float rosslerWarmStatesHF[WARM_STATES * 6] = {
+    2.3405763f, 0.076788555f, 0.060527931f, 2.1654887f, 1.036457f, -0.88582539f,
+    -3.0138473f, -9.4540456f, 0.035922461f, -3.1889349f, -8.4943772f, -0.91043086f,
+    7.7604131f, 3.5158514f, 0.18460833f, 7.5853255f, 4.4755198f, -0.76174499f,
+    0.15951149f, -10.969207f, 0.044853171f, -0.015576136f, -10.009539f, -0.90150015f,
+    2.4391763f, 0.90111043f, 0.061883765f, 2.2640887f, 1.8607788f, -0.88446956f,
+    -11.461896f, 2.7368397f, 0.023526323f, -11.636983f, 3.6965081f, -0.922827f,
+    14.674139f, -3.4432031f, 1.3545565f, 14.499051f, -2.4835347f, 0.40820314f,
+    15.140962f, -11.631673f, 0.58095926f, 14.965875f, -10.672004f, -0.36539406f
+};
+
+// Lorentz84 HF: mean 0.692352, 0.609168, 0.208504
+static constexpr float lorentz84WarmStatesHF[WARM_STATES * 6] = {
+    -0.13690548f, 1.3554799f, -0.06011967f, -0.82925712f, 0.74631196f, -0.2686237f,
+    1.6998371f, -0.059654342f, 1.5487518f, 1.0074855f, -0.66882228f, 1.3402478f,
+    0.50273425f, 1.002231f, 0.82843463f, -0.1896174f, 0.39306307f, 0.61993061f,
+    0.25700757f, 1.8711975f, 0.42158415f, -0.43534408f, 1.2620296f, 0.21308012f,
+    1.1617407f, -0.83849949f, -0.084429124f, 0.46938906f, -1.4476674f, -0.29293315f,
+    0.091149513f, 1.2190847f, -0.086517036f, -0.60120213f, 0.60991672f, -0.29502106f,
+    1.2974764f, -1.231767f, -1.1499066f, 0.60512472f, -1.8409349f, -1.3584106f,
+    0.63388848f, 0.32082491f, 1.254001f, -0.05846316f, -0.28834303f, 1.045497f
+};
+
+// Chua LF: mean 1.60886, 0.000557632, -1.60793
+static constexpr float chuaWarmStatesLF[WARM_STATES * 6] = {
+    1.5185001f, -0.01543658f, -1.0363023f, -0.090354909f, -0.015994211f, 0.57162586f,
+    1.09976f, -0.48344009f, -1.5765869f, -0.5090951f, -0.48399772f, 0.031341254f,
+    1.8288581f, 0.14406617f, -1.2994922f, 0.22000301f, 0.14350854f, 0.30843598f,
+    1.9100458f, 0.098554331f, -1.6833194f, 0.30119076f, 0.0979967f, -0.075391267f,
+    1.6846077f, -0.38557716f, -2.814095f, 0.07575266f, -0.38613479f, -1.2061669f,
+    0.38392298f, 0.13596284f, -0.62131852f, -1.2249321f, 0.13540521f, 0.98660961f,
+    1.9459031f, -0.05582573f, -2.3521345f, 0.33704809f, -0.056383362f, -0.74420632f,
+    2.3326476f, -0.20141522f, -3.9142182f, 0.72379257f, -0.20197285f, -2.3062901f
+};
+
+// Rossler LF: mean 0.17973, -0.989981, 0.985781
+static constexpr float rosslerWarmStatesLF[WARM_STATES * 6] = {
+    1.8125886f, -4.4085923f, 0.05453444f, 1.6328589f, -3.4186109f, -0.93124616f,
+    -1.4236765f, 1.4311281f, 0.042698354f, -1.6034061f, 2.4211095f, -0.94308224f,
+    13.018183f, 1.0569078f, 1.5150992f, 12.838453f, 2.0468892f, 0.52931857f,
+    -4.8865483f, -2.8638914f, 0.03272928f, -5.066278f, -1.8739101f, -0.95305132f,
+    11.324567f, 5.1851306f, 7.2625731f, 11.144838f, 6.1751119f, 6.2767925f,
+    -10.44644f, -6.4906971f, 0.024174982f, -10.62617f, -5.5007158f, -0.96160561f,
+    2.8952927f, 4.4441474f, 0.069499096f, 2.7155631f, 5.4341287f, -0.9162815f,
+    -0.31246525f, -2.3996532f, 0.045623844f, -0.49219488f, -1.4096718f, -0.94015675f
+};
+
+// Lorentz84 LF: mean 0.754335, 0.580087, 0.444813
+static constexpr float lorentz84WarmStatesLF[WARM_STATES * 6] = {
+    -0.13182423f, 1.2728395f, 1.17042f, -0.88615966f, 0.69275246f, 0.72560683f,
+    -0.027950935f, 1.2707949f, 1.3510405f, -0.78228636f, 0.69070789f, 0.90622725f,
+    0.12568745f, 1.3198097f, 1.4657454f, -0.62864798f, 0.7397227f, 1.0209322f,
+    0.32616771f, 1.4546485f, 1.4623342f, -0.42816771f, 0.87456146f, 1.017521f,
+    0.56049609f, 1.6769686f, 1.2720632f, -0.19383934f, 1.0968815f, 0.82724994f,
+    0.80580452f, 1.9128551f, 0.82795452f, 0.051469094f, 1.3327681f, 0.3831413f,
+    1.0348032f, 1.9967518f, 0.12507901f, 0.28046773f, 1.4166648f, -0.31973421f,
+    1.2251516f, 1.7353447f, -0.70310779f, 0.47081613f, 1.1552577f, -1.147921f
+};
@@ -0,0 +1,233 @@
+#pragma once
+#include "Kernels.hpp"
+#include "Network.hpp"
+#include <cstring>
+
+
+// Kernels of Kernels.hpp, included only by KernelsAVX2.cpp and KernelsAVX512.cpp. Those units
+// are built like the rest of the plugin, for SSE: Rack's headers and every inline of the
+// plugin they pull in, and the static initializers run when the plugin loads, must not use an
+// instruction the CPU may lack. Only the code below targets WIDE_ISA, the instruction set the
+// unit defines before including this, and all of it is in an anonymous namespace, local to
+// the unit. The kernels are flattened, so the integrators and systems of the shared headers,
+// built for SSE where they are defined, are inlined into them rather than called.
+
+#ifndef WIDE_ISA
+#error "Define WIDE_ISA before including Wide.hpp"
+#endif
+
+#define WIDE_PRAGMA(x) _Pragma(#x)
+#ifdef __clang__
+#define WIDE_PUSH(isa) WIDE_PRAGMA(clang attribute push (__attribute__((target(isa))), apply_to = function))
+#define WIDE_POP WIDE_PRAGMA(clang attribute pop)
+#else
+#define WIDE_PUSH(isa) WIDE_PRAGMA(GCC push_options) WIDE_PRAGMA(GCC target(isa))
+#define WIDE_POP WIDE_PRAGMA(GCC pop_options)
+#endif
+
+WIDE_PUSH(WIDE_ISA)
+
+namespace {
+
+// Vector types of 8 and 16 floats, spelled out since GCC ignores a vector_size that depends
+// on a template parameter
+template <int N>
+struct WideVector;
+
+template <>
+struct WideVector<8> {
+    typedef float V __attribute__((vector_size(32)));
+    typedef int32_t I __attribute__((vector_size(32)));
+};
+
+template <>
+struct WideVector<16> {
+    typedef float V __attribute__((vector_size(64)));
+    typedef int32_t I __attribute__((vector_size(64)));
+};
+
+/** N floats as one lane type, on the vector extensions of GCC and Clang, which compile each
+operation into as few instructions as the instruction set of the kernel allows: one for 8
+floats in AVX2, one for 16 in AVX-512
+*/
+template <int N>
+struct Wide {
+    typedef typename WideVector<N>::V V;
+    typedef typename WideVector<N>::I I;
+    V v;
+
+    Wide() = default;
+    // A scalar operand is broadcast, one instruction where a loop over the lanes is not
+    // always turned into one
+    Wide(float x) : v(V{} + x) {}
+
+    static Wide make(V v) {
+        Wide r;
+        r.v = v;
+        return r;
+    }
+
+    /** The first n floats of p, zero after them */
+    static Wide load(const float* p, int n) {
+        Wide r;
+        if (n >= N) {
+            std::memcpy(&r.v, p, sizeof(V));
+            return r;
+        }
+        for (int i = 0; i < N; i++)
+            r.v[i] = (i < n) ? p[i] : 0.f;
+        return r;
+    }
+
+    void store(float* p, int n) const {
+        if (n >= N) {
+            std::memcpy(p, &v, sizeof(V));
+            return;
+        }
+        for (int i = 0; i < n; i++)
+            p[i] = v[i];
+    }
+};
+
+#define WIDE_OPERATOR(op) \
+    template <int N> \
+    inline Wide<N> operator op(const Wide<N>& a, const Wide<N>& b) { \
+        return Wide<N>::make(a.v op b.v); \
+    } \
+    template <int N> \
+    inline Wide<N> operator op(const Wide<N>& a, float b) { \
+        return Wide<N>::make(a.v op Wide<N>(b).v); \
+    } \
+    template <int N> \
+    inline Wide<N> operator op(float a, const Wide<N>& b) { \
+        return Wide<N>::make(Wide<N>(a).v op b.v); \
+    }
+
+WIDE_OPERATOR(+)
+WIDE_OPERATOR(-)
+WIDE_OPERATOR(*)
+WIDE_OPERATOR(/)
+
+#undef WIDE_OPERATOR
+
+template <int N>
+inline Wide<N> operator-(const Wide<N>& a) {
+    return Wide<N>::make(-a.v);
+}
+
+template <int N>
+inline Wide<N> abs(const Wide<N>& a) {
+    typedef typename Wide<N>::V V;
+    typedef typename Wide<N>::I I;
+    I mask;
+    for (int i = 0; i < N; i++)
+        mask[i] = 0x7fffffff;
+    return Wide<N>::make((V) ((I) a.v & mask));
+}
+
+/** Value of node `i`, for Coupled */
+template <int N>
+inline float lane(const Wide<N>& a, int i) {
+    return a.v[i];
+}
+
+} // namespace
+
+template <int N>
+struct NodeTraits<Wide<N>> {
+    static constexpr int BLOCKS = N / 4;
+};
+
+namespace {
+
+/** Independent voices in chunks of W lanes, coefficient rows `lanes` floats apart */
+template <int W, class System, class Integrator>
+void integrateVoices(float* x, float* y, float* z, const float* k, const float* h, int lanes, int substeps) {
+    typedef Wide<W> T;
+    for (int i = 0; i < lanes; i += W) {
+        int n = lanes - i;
+        Vec3<T> s{T::load(x + i, n), T::load(y + i, n), T::load(z + i, n)};
+        T kw[System::NUM_COEFFS];
+        for (int j = 0; j < System::NUM_COEFFS; j++)
+            kw[j] = T::load(k + j * lanes + i, n);
+        T hw = T::load(h + i, n);
+        for (int step = 0; step < substeps; step++)
+            Integrator::template step<System>(s, kw, hw);
+        s.x.store(x + i, n);
+        s.y.store(y + i, n);
+        s.z.store(z + i, n);
+    }
+}
+
+/** Coupled on Wide, the nodes broadcast from memory rather than taken out of a register one
+by one for the means, the same sums in the same order
+*/
+template <class System>
+struct WideCoupled : Coupled<System> {
+    template <typename T>
+    static Vec3<T> derive(const Vec3<T>& s, const T* k) {
+        Vec3<T> d = System::derive(s, k);
+        const T* w = k + System::NUM_COEFFS + 1;
+        float x[sizeof(T) / sizeof(float)];
+        std::memcpy(x, &s.x, sizeof(x));
+        T mean = w[0] * T(x[0]);
+        for (int j = 1; j < (int) (sizeof(T) / sizeof(float)); j++)
+            mean = mean + w[j] * T(x[j]);
+        d.x = d.x + k[System::NUM_COEFFS] * (mean - s.x);
+        return d;
+    }
+};
+
+/** Every node of a network in one vector of W >= lanes, the weight columns past the nodes
+left at zero
+*/
+template <int W, class System, class Integrator>
+void integrateNetwork(float* x, float* y, float* z, const float* k, const float* h, int lanes, int substeps) {
+    typedef Wide<W> T;
+    const int rows = System::NUM_COEFFS + 1 + lanes;
+    Vec3<T> s{T::load(x, lanes), T::load(y, lanes), T::load(z, lanes)};
+    T kw[System::NUM_COEFFS + 1 + W];
+    for (int j = 0; j < System::NUM_COEFFS + 1 + W; j++)
+        kw[j] = (j < rows) ? T::load(k + j * lanes, lanes) : T(0.f);
+    T hw = T::load(h, lanes);
+    for (int step = 0; step < substeps; step++)
+        Integrator::template step<WideCoupled<System>>(s, kw, hw);
+    s.x.store(x, lanes);
+    s.y.store(y, lanes);
+    s.z.store(z, lanes);
+}
+
+template <class System, class Integrator>
+__attribute__((flatten)) void voices(float* x, float* y, float* z, const float* k, const float* h, int lanes, int substeps) {
+    if (lanes <= 8)
+        integrateVoices<8, System, Integrator>(x, y, z, k, h, lanes, substeps);
+    else
+        integrateVoices<16, System, Integrator>(x, y, z, k, h, lanes, substeps);
+}
+
+template <class System, class Integrator>
+__attribute__((flatten)) void network(float* x, float* y, float* z, const float* k, const float* h, int lanes, int substeps) {
+    if (lanes <= 8)
+        integrateNetwork<8, System, Integrator>(x, y, z, k, h, lanes, substeps);
+    else
+        integrateNetwork<16, System, Integrator>(x, y, z, k, h, lanes, substeps);
+}
+
+/** The table of a unit, a constant so that no kernel runs before init() has checked that
+the CPU has its instruction set
+*/
+constexpr WideKernels makeWideKernels(const char* name, int width) {
+    return WideKernels{name, width, {
+        {voices<Chua, EulerIntegrator>, voices<Chua, HeunIntegrator>, voices<Chua, RK4Integrator>, voices<Chua, SemiImplicitIntegrator>},
+        {voices<Rossler, EulerIntegrator>, voices<Rossler, HeunIntegrator>, voices<Rossler, RK4Integrator>, voices<Rossler, SemiImplicitIntegrator>},
+        {voices<Lorentz84, EulerIntegrator>, voices<Lorentz84, HeunIntegrator>, voices<Lorentz84, RK4Integrator>, voices<Lorentz84, SemiImplicitIntegrator>}
+    }, {
+        {network<Chua, EulerIntegrator>, network<Chua, HeunIntegrator>, network<Chua, RK4Integrator>, network<Chua, SemiImplicitIntegrator>},
+        {network<Rossler, EulerIntegrator>, network<Rossler, HeunIntegrator>, network<Rossler, RK4Integrator>, network<Rossler, SemiImplicitIntegrator>},
+        {network<Lorentz84, EulerIntegrator>, network<Lorentz84, HeunIntegrator>, network<Lorentz84, RK4Integrator>, network<Lorentz84, SemiImplicitIntegrator>}
+    }};
+}
+
+} // namespace
+
+WIDE_POP
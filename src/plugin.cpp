@@ -1,11 +1,15 @@
 #include "plugin.hpp"
+#include "Profile.hpp"
+#include "Kernels.hpp"
 
 
 Plugin* pluginInstance;
+thread_local ProfileCounters* ProfileCounters::timing = nullptr;
 
 
 void init(Plugin* p) {
 	pluginInstance = p;
+	selectWideKernels();
 
 	// Add modules here
 	// p->addModel(modelMyModule);
@@ -13,6 +17,8 @@ void init(Plugin* p) {
     p->addModel(modelJulioRossler);
     p->addModel(modelJulioChua);
     p->addModel(modelJulioLorentz84);
+    p->addModel(modelJulioCluster);
+    p->addModel(modelJulioODE);
     
 	// Any other plugin initialization may go here.
 	// As an alternative, consider lazy-loading assets and lookup tables when your module is created to reduce startup times of Rack.
@@ -10,5 +10,7 @@ extern Plugin* pluginInstance;
 extern Model* modelJulioRossler;
 extern Model* modelJulioChua;
 extern Model* modelJulioLorentz84;
+extern Model* modelJulioCluster;
+extern Model* modelJulioODE;
 // Declare each Model, defined in each module source file
 // extern Model* modelMyModule;
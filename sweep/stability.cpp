@@ -0,0 +1,163 @@
+// Stability maps of the built-in systems, written to src/StabilityMap.hpp with
+// `build/sweep --stability-map src/StabilityMap.hpp`.
+#include "sweep.hpp"
+#include <cctype>
+#include <climits>
+
+
+static const int CELLS = 12;                // per knob, STABILITY_CELLS of the maps
+static const int STARTS_GRID = 3;           // settings per knob whose attractors give start states
+static const int STARTS_PER_ATTRACTOR = 4;
+static const int STEPS_PER_PERIOD = 100;
+static const int SETTLE_PERIODS = 50;
+static const int TEST_PERIODS = 30;
+
+
+/** Whether the solution from s leaves the bounds of the divergence test of the modules,
+s left where it stopped
+*/
+template <class System>
+static bool escapes(Vec3<double>& s, const double* k, double h, int steps) {
+    const Vec3<float> c = System::clipScale();
+    for (int i = 0; i < steps; i++) {
+        RK4Integrator::step<System>(s, k, h);
+        if (!(std::fabs(s.x * c.x) <= 12.0 && std::fabs(s.y * c.y) <= 12.0 && std::fabs(s.z * c.z) <= 12.0))
+            return true;
+    }
+    return false;
+}
+
+/** States a voice can be in when the knobs or CV move: the initial conditions, and points
+on the attractors of a grid of settings
+*/
+template <class System>
+static std::vector<Vec3<double>> startStates(double h) {
+    std::vector<Vec3<double>> starts;
+    starts.push_back(System::template initial<double>());
+    for (int i = 0; i < STARTS_GRID * STARTS_GRID * STARTS_GRID; i++) {
+        float u[3] = {
+            (float) (i / (STARTS_GRID * STARTS_GRID)) / (STARTS_GRID - 1),
+            (float) (i / STARTS_GRID % STARTS_GRID) / (STARTS_GRID - 1),
+            (float) (i % STARTS_GRID) / (STARTS_GRID - 1)
+        };
+        double k[System::NUM_COEFFS];
+        coefficients<System>(u, k);
+        Vec3<double> s = System::template initial<double>();
+        if (escapes<System>(s, k, h, SETTLE_PERIODS * STEPS_PER_PERIOD))
+            continue;
+        for (int j = 0; j < STARTS_PER_ATTRACTOR; j++) {
+            for (int n = 0; n < STEPS_PER_PERIOD * 5 / 4; n++)
+                RK4Integrator::step<System>(s, k, h);
+            starts.push_back(s);
+        }
+    }
+    return starts;
+}
+
+/** Map of one system: a cell is divergent when any start state escapes at its center or at
+one of its corners, and points to the nearest stable cell, itself when stable
+*/
+template <class System>
+static std::string mapSource(const std::string& name, int threads) {
+    const int n = CELLS;
+    const double h = System::PERIOD / STEPS_PER_PERIOD;
+    const std::vector<Vec3<double>> starts = startStates<System>(h);
+
+    // Cell centers first, then the (n + 1)^3 corners
+    const int centers = n * n * n;
+    const int corners = (n + 1) * (n + 1) * (n + 1);
+    std::vector<char> escaped(centers + corners);
+    WorkStealingPool pool;
+    pool.run(centers + corners, threads, [&](int i) {
+        float u[3];
+        if (i < centers) {
+            u[0] = (i / (n * n) + 0.5f) / n;
+            u[1] = (i / n % n + 0.5f) / n;
+            u[2] = (i % n + 0.5f) / n;
+        }
+        else {
+            int j = i - centers;
+            u[0] = (float) (j / ((n + 1) * (n + 1))) / n;
+            u[1] = (float) (j / (n + 1) % (n + 1)) / n;
+            u[2] = (float) (j % (n + 1)) / n;
+        }
+        double k[System::NUM_COEFFS];
+        coefficients<System>(u, k);
+        bool e = false;
+        for (size_t j = 0; j < starts.size() && !e; j++) {
+            Vec3<double> s = starts[j];
+            e = escapes<System>(s, k, h, TEST_PERIODS * STEPS_PER_PERIOD);
+        }
+        escaped[i] = e;
+    });
+
+    std::vector<bool> stable(centers);
+    int divergent = 0;
+    for (int i = 0; i < centers; i++) {
+        int a = i / (n * n), b = i / n % n, c = i % n;
+        bool e = escaped[i];
+        for (int corner = 0; corner < 8; corner++)
+            e = e || escaped[centers + ((a + (corner >> 2)) * (n + 1) + b + ((corner >> 1) & 1)) * (n + 1) + c + (corner & 1)];
+        stable[i] = !e;
+        divergent += e;
+    }
+
+    std::string var = name + "Stability";
+    var[0] = std::tolower(var[0]);
+    if (divergent == 0)
+        return string::f("// %s: every cell is stable\nstatic constexpr const uint16_t* %s = nullptr;\n", name.c_str(), var.c_str());
+    if (divergent == centers)
+        return string::f("// %s: no stable cell\nstatic constexpr const uint16_t* %s = nullptr;\n", name.c_str(), var.c_str());
+
+    std::string source = string::f("// %s: %d of %d cells diverge\nstatic constexpr uint16_t %s[%d] = {", name.c_str(), divergent, centers, var.c_str(), centers);
+    for (int i = 0; i < centers; i++) {
+        int nearest = i;
+        if (!stable[i]) {
+            int best = INT_MAX;
+            for (int j = 0; j < centers; j++) {
+                if (!stable[j])
+                    continue;
+                int da = j / (n * n) - i / (n * n), db = j / n % n - i / n % n, dc = j % n - i % n;
+                int d = da * da + db * db + dc * dc;
+                if (d < best) {
+                    best = d;
+                    nearest = j;
+                }
+            }
+        }
+        source += string::f("%s%d,", (i % 16 == 0) ? "\n    " : " ", nearest);
+    }
+    source.pop_back();
+    return source + "\n};\n";
+}
+
+
+int stabilityMap(const std::string& path, int threads) {
+    std::string source =
+        "#pragma once\n"
+        "#include <cstdint>\n"
+        "\n"
+        "\n"
+        "// Generated by `build/sweep --stability-map src/StabilityMap.hpp`, see sweep/stability.cpp.\n"
+        "//\n"
+        "// Each system's P1 to P3 knob range is cut in STABILITY_CELLS^3 cells, P1 the slowest index.\n"
+        "// A cell diverges when a voice coming from the initial conditions or from the attractor of\n"
+        "// another setting can leave its basin there and hit the divergence test. Each entry is the\n"
+        "// nearest stable cell, the cell itself when it is stable.\n";
+    source += string::f("static const int STABILITY_CELLS = %d;\n", CELLS);
+    printf("Chua\n");
+    source += "\n" + mapSource<Chua>("Chua", threads);
+    printf("Rossler\n");
+    source += "\n" + mapSource<Rossler>("Rossler", threads);
+    printf("Lorentz84\n");
+    source += "\n" + mapSource<Lorentz84>("Lorentz84", threads);
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return 1;
+    }
+    std::fputs(source.c_str(), f);
+    std::fclose(f);
+    return 0;
+}
@@ -0,0 +1,439 @@
+// Offline renderer of a grid of P1 to P3 settings, outside of Rack.
+// Build and run with `make sweep`, see the Makefile for the options.
+#include "sweep.hpp"
+#include "UserSystem.hpp"
+#include "Expander.hpp"
+#include <cstdlib>
+
+
+static const int FFT_LEN = 1024;
+static const int MAX_LOOPS = 8;             // returns to the section per cycle of a periodic orbit
+static const int RETURNS = 64;              // last returns compared
+static const float RETURN_TOLERANCE = 1e-3f;    // relative to the span of X
+static const float STILL_SPAN = 0.01f;      // V, below it X has settled to a point
+
+
+/** Values of one knob, "v" or "from:to:steps" */
+struct Axis {
+    float from = 0.f;
+    float to = 1.f;
+    int steps = 5;
+
+    float at(int i) const {
+        return (steps > 1) ? from + (to - from) * i / (steps - 1) : from;
+    }
+};
+
+
+struct SweepOptions {
+    std::string model = "JulioChua";
+    Axis axes[3];
+    float rate = 0.5f;
+    bool lf = false;
+    int quality = Ids::QUALITY_NORMAL;
+    int integrator = -1;        // the module's default
+    float sampleRate = 48000.f;
+    float settle = 1.f;
+    float seconds = 2.f;
+    int threads = 0;
+    std::string outDir = "build/sweep";
+    bool wav = true;
+    std::string stabilityPath;
+    std::string warmPath;
+};
+
+
+struct PointResult {
+    float p[3];
+    double divergences;     // per second, lanes reset by the divergence test
+    double clipped;         // share of the samples with an output beyond ±10 V
+    double centroid[3];     // Hz
+    std::string orbit;
+    int loops;              // returns to the section per cycle when periodic
+    std::string wav;
+};
+
+
+/** Spectral centroid of a signal, from Hann windowed frames */
+struct CentroidAccumulator {
+    alignas(16) float frame[FFT_LEN];
+    alignas(16) float spectrum[FFT_LEN];
+    double power[FFT_LEN / 2] = {};
+    int framePos = 0;
+    dsp::RealFFT fft{FFT_LEN};
+
+    void process(float x) {
+        frame[framePos] = x * (0.5f - 0.5f * std::cos(2.f * M_PI * framePos / FFT_LEN));
+        if (++framePos == FFT_LEN) {
+            fft.rfft(frame, spectrum);
+            for (int i = 1; i < FFT_LEN / 2; i++)
+                power[i] += spectrum[2 * i] * spectrum[2 * i] + spectrum[2 * i + 1] * spectrum[2 * i + 1];
+            framePos = 0;
+        }
+    }
+
+    double get(float sampleRate) const {
+        double weighted = 0.0;
+        double total = 0.0;
+        for (int i = 1; i < FFT_LEN / 2; i++) {
+            weighted += i * power[i];
+            total += power[i];
+        }
+        return (total > 0.0) ? weighted / total * sampleRate / FFT_LEN : 0.0;
+    }
+};
+
+
+/** Periodic or not from a Poincaré section of the X output, its maxima, as in CycleCache.hpp
+but over the whole render and with a looser tolerance, since it sees the outputs in float
+after the DC blocker. The orbit is periodic when the last returns repeat every 1 to
+MAX_LOOPS returns, still when X does not move, and unknown when it has too few returns.
+*/
+struct OrbitClassifier {
+    float x0 = 0.f;
+    float x1 = 0.f;
+    long t = 0;
+    float lo = INFINITY;
+    float hi = -INFINITY;
+    std::deque<float> maxima;
+
+    void process(float x) {
+        if (t++ >= 2 && x1 > x0 && x1 >= x) {
+            float d = x0 - 2.f * x1 + x;
+            float offset = (d < 0.f) ? clamp(0.5f * (x0 - x) / d, -0.5f, 0.5f) : 0.f;
+            maxima.push_back(x1 - 0.25f * (x0 - x) * offset);
+            if ((int) maxima.size() > RETURNS)
+                maxima.pop_front();
+        }
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+        x0 = x1;
+        x1 = x;
+    }
+
+    std::string classify(int* loops) const {
+        *loops = 0;
+        float span = hi - lo;
+        if (!(span >= STILL_SPAN))
+            return "still";
+        int n = maxima.size();
+        if (n < 3 * MAX_LOOPS)
+            return "unknown";
+        for (int l = 1; l <= MAX_LOOPS; l++) {
+            bool repeats = true;
+            for (int i = l; i < n && repeats; i++)
+                repeats = std::fabs(maxima[i] - maxima[i - l]) <= RETURN_TOLERANCE * span;
+            if (repeats) {
+                *loops = l;
+                return "periodic";
+            }
+        }
+        return "chaotic";
+    }
+};
+
+
+/** 32-bit float WAV file with the X, Y and Z outputs, written as it is rendered */
+struct WavWriter {
+    FILE* f = nullptr;
+
+    static void put16(FILE* f, uint16_t v) {
+        uint8_t b[2] = {(uint8_t) v, (uint8_t) (v >> 8)};
+        std::fwrite(b, 1, 2, f);
+    }
+
+    static void put32(FILE* f, uint32_t v) {
+        uint8_t b[4] = {(uint8_t) v, (uint8_t) (v >> 8), (uint8_t) (v >> 16), (uint8_t) (v >> 24)};
+        std::fwrite(b, 1, 4, f);
+    }
+
+    bool open(const std::string& path, int channels, int sampleRate, uint32_t frames) {
+        f = std::fopen(path.c_str(), "wb");
+        if (!f)
+            return false;
+        uint32_t bytes = frames * channels * 4;
+        std::fwrite("RIFF", 1, 4, f);
+        put32(f, 4 + 26 + 12 + 8 + bytes);
+        std::fwrite("WAVE", 1, 4, f);
+        // IEEE float format, with the extension size and the fact chunk non-PCM files have
+        std::fwrite("fmt ", 1, 4, f);
+        put32(f, 18);
+        put16(f, 3);
+        put16(f, channels);
+        put32(f, sampleRate);
+        put32(f, sampleRate * channels * 4);
+        put16(f, channels * 4);
+        put16(f, 32);
+        put16(f, 0);
+        std::fwrite("fact", 1, 4, f);
+        put32(f, 4);
+        put32(f, frames);
+        std::fwrite("data", 1, 4, f);
+        put32(f, bytes);
+        return true;
+    }
+
+    /** Interleaved samples, little-endian as on every platform Rack runs on */
+    void write(const float* samples, int count) {
+        std::fwrite(samples, sizeof(float), count, f);
+    }
+
+    void close() {
+        if (f)
+            std::fclose(f);
+        f = nullptr;
+    }
+};
+
+
+template <class System>
+static bool readDivergences(Module* m, int64_t* divergences) {
+    ChaosModule<System>* chaos = dynamic_cast<ChaosModule<System>*>(m);
+    if (chaos)
+        *divergences = chaos->divergences;
+    return chaos;
+}
+
+static int64_t divergencesOf(Module* m) {
+    int64_t divergences = 0;
+    readDivergences<Chua>(m, &divergences) || readDivergences<Rossler>(m, &divergences)
+        || readDivergences<Lorentz84>(m, &divergences) || readDivergences<UserSystem>(m, &divergences);
+    return divergences;
+}
+
+
+static PointResult renderPoint(Model* model, const int index[3], const SweepOptions& options) {
+    PointResult result;
+    for (int a = 0; a < 3; a++)
+        result.p[a] = options.axes[a].at(index[a]);
+
+    Module* m = model->createModule();
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "quality", json_integer(options.quality));
+    if (options.integrator >= 0)
+        json_object_set_new(rootJ, "integrator", json_integer(options.integrator));
+    m->dataFromJson(rootJ);
+    json_decref(rootJ);
+    m->params[Ids::RATE_PARAM].setValue(options.rate);
+    for (int a = 0; a < 3; a++)
+        m->params[Ids::P1_PARAM + a].setValue(result.p[a]);
+    m->params[Ids::RANGE_PARAM].setValue(options.lf ? 1.f : 0.f);
+    for (int i = 0; i < Ids::OUTPUTS_LEN; i++)
+        m->outputs[i].channels = 1;
+
+    Module::ProcessArgs args;
+    args.sampleRate = options.sampleRate;
+    args.sampleTime = 1.f / options.sampleRate;
+    args.frame = 0;
+    int64_t settle = (int64_t) (options.settle * options.sampleRate);
+    int64_t frames = (int64_t) (options.seconds * options.sampleRate);
+    for (int64_t i = 0; i < settle; i++, args.frame++)
+        m->process(args);
+    int64_t divergences0 = divergencesOf(m);
+
+    WavWriter wav;
+    if (options.wav) {
+        result.wav = string::f("%s_%d_%d_%d.wav", model->slug.c_str(), index[0], index[1], index[2]);
+        if (!wav.open(options.outDir + "/" + result.wav, 3, (int) options.sampleRate, frames)) {
+            fprintf(stderr, "Could not write %s\n", result.wav.c_str());
+            result.wav = "";
+        }
+    }
+
+    CentroidAccumulator* centroids = new CentroidAccumulator[3];
+    OrbitClassifier orbit;
+    int64_t clipped = 0;
+    float block[256 * 3];
+    int blockPos = 0;
+    for (int64_t i = 0; i < frames; i++, args.frame++) {
+        m->process(args);
+        bool clip = false;
+        for (int a = 0; a < 3; a++) {
+            float v = m->outputs[Ids::X_OUTPUT + a].getVoltage();
+            centroids[a].process(v);
+            clip |= !(std::fabs(v) <= 10.f);
+            block[blockPos++] = v;
+        }
+        clipped += clip;
+        orbit.process(block[blockPos - 3]);
+        if (blockPos == (int) LENGTHOF(block) || i == frames - 1) {
+            if (wav.f)
+                wav.write(block, blockPos);
+            blockPos = 0;
+        }
+    }
+    wav.close();
+
+    result.divergences = (divergencesOf(m) - divergences0) / std::max(options.seconds, 1e-6f);
+    result.clipped = (double) clipped / std::max(frames, (int64_t) 1);
+    for (int a = 0; a < 3; a++)
+        result.centroid[a] = centroids[a].get(options.sampleRate);
+    result.orbit = orbit.classify(&result.loops);
+    delete[] centroids;
+    delete m;
+    return result;
+}
+
+
+static void writeCsv(const std::vector<PointResult>& results, const std::string& model, const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return;
+    }
+    fprintf(f, "model,p1,p2,p3,divergencesPerSec,clipped,centroidX,centroidY,centroidZ,orbit,loops,wav\n");
+    for (const PointResult& r : results)
+        fprintf(f, "%s,%g,%g,%g,%.3f,%.6f,%.1f,%.1f,%.1f,%s,%d,%s\n", model.c_str(), r.p[0], r.p[1], r.p[2], r.divergences, r.clipped, r.centroid[0], r.centroid[1], r.centroid[2], r.orbit.c_str(), r.loops, r.wav.c_str());
+    std::fclose(f);
+}
+
+
+static bool parseAxis(const char* s, Axis* axis) {
+    char* end;
+    axis->from = axis->to = std::strtod(s, &end);
+    axis->steps = 1;
+    if (end == s)
+        return false;
+    if (*end == '\0')
+        return true;
+    if (*end != ':')
+        return false;
+    const char* p = end + 1;
+    axis->to = std::strtod(p, &end);
+    if (end == p || *end != ':')
+        return false;
+    axis->steps = std::atoi(end + 1);
+    return axis->steps >= 1;
+}
+
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: sweep [options]\n"
+        "  --model SLUG         module to render, default JulioChua\n"
+        "  --p1 FROM:TO:STEPS   knob positions of P1, or a single value, default 0:1:5\n"
+        "  --p2 FROM:TO:STEPS   same for P2\n"
+        "  --p3 FROM:TO:STEPS   same for P3\n"
+        "  --rate R             Rate knob, default 0.5\n"
+        "  --range NAME         hf or lf, default hf\n"
+        "  --quality NAME       eco, normal, high or auto, default normal\n"
+        "  --integrator NAME    euler, heun, rk4 or semi-implicit, default the module's\n"
+        "  --sample-rate SR     default 48000\n"
+        "  --settle S           rendered and left out before each point, default 1\n"
+        "  --seconds S          rendered and analyzed per point, default 2\n"
+        "  --threads N          default one per core\n"
+        "  --out DIR            WAV files and sweep.csv, default build/sweep\n"
+        "  --no-wav             only write sweep.csv\n"
+        "  --stability-map FILE instead of rendering, write the stability maps of the built-in\n"
+        "                       systems to this header, src/StabilityMap.hpp\n"
+        "  --warm-states FILE   instead of rendering, write the warm start states of the built-in\n"
+        "                       systems to this header, src/WarmStates.hpp\n");
+}
+
+
+template <size_t N>
+static int findName(const char* const (&names)[N], const std::string& name) {
+    for (int i = 0; i < (int) N; i++)
+        if (name == names[i])
+            return i;
+    return -1;
+}
+
+
+int main(int argc, char** argv) {
+    SweepOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-wav") {
+            options.wav = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        bool ok = true;
+        if (arg == "--model")
+            options.model = value;
+        else if (arg == "--p1" || arg == "--p2" || arg == "--p3")
+            ok = parseAxis(value, &options.axes[arg[3] - '1']);
+        else if (arg == "--rate")
+            options.rate = clamp((float) std::atof(value), 0.f, 1.f);
+        else if (arg == "--range") {
+            options.lf = std::string(value) == "lf";
+            ok = options.lf || std::string(value) == "hf";
+        }
+        else if (arg == "--quality")
+            ok = (options.quality = findName(QUALITY_NAMES, value)) >= 0;
+        else if (arg == "--integrator")
+            ok = (options.integrator = findName(INTEGRATOR_NAMES, value)) >= 0;
+        else if (arg == "--sample-rate")
+            options.sampleRate = std::atof(value);
+        else if (arg == "--settle")
+            options.settle = std::max(0.f, (float) std::atof(value));
+        else if (arg == "--seconds")
+            options.seconds = std::atof(value);
+        else if (arg == "--threads")
+            options.threads = std::atoi(value);
+        else if (arg == "--out")
+            options.outDir = value;
+        else if (arg == "--stability-map")
+            options.stabilityPath = value;
+        else if (arg == "--warm-states")
+            options.warmPath = value;
+        else
+            ok = false;
+        if (!ok || !(options.sampleRate > 0.f) || !(options.seconds > 0.f)) {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!options.stabilityPath.empty())
+        return stabilityMap(options.stabilityPath, options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency()));
+    if (!options.warmPath.empty())
+        return warmStates(options.warmPath);
+
+    Plugin* p = new Plugin;
+    init(p);
+
+    Model* model = nullptr;
+    for (Model* m : p->models)
+        if (m->slug == options.model)
+            model = m;
+    // The cluster has its own parameters and ports
+    Module* probe = model ? model->createModule() : nullptr;
+    bool chaos = isChaosModule(probe);
+    delete probe;
+    if (!chaos) {
+        fprintf(stderr, "%s is not one of the oscillators\n", options.model.c_str());
+        return 1;
+    }
+    if (!system::createDirectories(options.outDir)) {
+        fprintf(stderr, "Could not create %s\n", options.outDir.c_str());
+        return 1;
+    }
+
+    const Axis* axes = options.axes;
+    int points = axes[0].steps * axes[1].steps * axes[2].steps;
+    int threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, points);
+    printf("%s, %d points on %d threads\n", model->slug.c_str(), points, threads);
+    printf("%6s %6s %6s %12s %8s %10s %10s %10s %s\n", "p1", "p2", "p3", "divergences", "clipped", "centroidX", "centroidY", "centroidZ", "orbit");
+
+    std::vector<PointResult> results(points);
+    std::mutex printMutex;
+    WorkStealingPool pool;
+    pool.run(points, threads, [&](int i) {
+        int index[3] = {i / (axes[1].steps * axes[2].steps), i / axes[2].steps % axes[1].steps, i % axes[2].steps};
+        PointResult r = renderPoint(model, index, options);
+        std::lock_guard<std::mutex> lock(printMutex);
+        printf("%6.3f %6.3f %6.3f %12.2f %8.4f %10.1f %10.1f %10.1f %s\n", r.p[0], r.p[1], r.p[2], r.divergences, r.clipped, r.centroid[0], r.centroid[1], r.centroid[2], r.orbit.c_str());
+        fflush(stdout);
+        results[i] = r;
+    });
+
+    writeCsv(results, model->slug, options.outDir + "/sweep.csv");
+    return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "bench.hpp"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <pmmintrin.h>
+
+
+/** Per-thread deques of task indices. Each thread takes its tasks from the back of its own
+deque and, once it is empty, steals from the front of the others, so that threads that got
+the slow corners of the grid are helped by the rest.
+*/
+struct WorkStealingPool {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+    std::vector<Queue> queues;
+
+    /** Runs f on every task in [0, tasks) on `threads` threads and waits for them */
+    void run(int tasks, int threads, const std::function<void(int)>& f) {
+        queues = std::vector<Queue>(threads);
+        // Contiguous blocks, neighbouring points cost about the same
+        for (int i = 0; i < tasks; i++)
+            queues[(int64_t) i * threads / tasks].tasks.push_back(i);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([this, t, &f]() {
+                // Flush denormals to zero, as Rack does in its engine threads
+                _mm_setcsr(_mm_getcsr() | 0x8040);
+                int task;
+                while (take(t, &task))
+                    f(task);
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    /** No task is ever added, so when every deque is empty the work is done */
+    bool take(int self, int* task) {
+        int n = queues.size();
+        for (int i = 0; i < n; i++) {
+            Queue& q = queues[(self + i) % n];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+            if (i == 0) {
+                *task = q.tasks.back();
+                q.tasks.pop_back();
+            }
+            else {
+                *task = q.tasks.front();
+                q.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+
+/** Coefficients of System at knob positions u, as the modules map them without CV */
+template <class System>
+inline void coefficients(const float u[3], double* k) {
+    for (int i = 0; i < System::NUM_COEFFS; i++) {
+        const ParamMap m = System::paramMap(i);
+        k[i] = clamp(m.offset + m.scale * u[m.param], m.min, m.max);
+    }
+}
+
+
+/** Writes the stability maps of the built-in systems as a C++ header, see stability.cpp.
+Returns the process exit status.
+*/
+int stabilityMap(const std::string& path, int threads);
+
+/** Writes the warm start states of the built-in systems as a C++ header, see warm.cpp.
+Returns the process exit status.
+*/
+int warmStates(const std::string& path);
@@ -0,0 +1,81 @@
+// Warm start states of the built-in systems, written to src/WarmStates.hpp with
+// `build/sweep --warm-states src/WarmStates.hpp`.
+#include "sweep.hpp"
+#include <cctype>
+
+
+static const int STATES = 8;                // WARM_STATES of the header
+static const int SETTLE_PERIODS = 100;
+// Between states, a fractional number of periods so that they do not all fall on the same
+// phase of a periodic orbit
+static const double PERIODS_PER_STATE = 25.618;
+
+
+/** States of one system at the middle of the knobs, spread over its attractor, each with
+its offset from the mean of the attractor, which is what a settled DC blocker outputs.
+The solution is the one the modules play by default in each range, Euler at the step of
+the middle of the Rate knob at 48 kHz: the HF step is long enough to turn the single scroll
+of Chua into a double scroll, so the attractors of both ranges differ.
+*/
+template <class System>
+static std::string statesSource(const std::string& name, bool lf) {
+    const float u[3] = {0.5f, 0.5f, 0.5f};
+    double k[System::NUM_COEFFS];
+    coefficients<System>(u, k);
+    const double h = 0.5 * (lf ? System::RATE_LF : System::RATE_HF) / 48000.0;
+    const Vec3<float> c = System::clipScale();
+
+    std::string var = name + (lf ? "WarmStatesLF" : "WarmStatesHF");
+    var[0] = std::tolower(var[0]);
+    Vec3<double> s = System::template initial<double>();
+    std::vector<Vec3<double>> states;
+    Vec3<double> sum{0.0, 0.0, 0.0};
+    const int settle = SETTLE_PERIODS * System::PERIOD / h;
+    const int perState = PERIODS_PER_STATE * System::PERIOD / h;
+    const int steps = STATES * perState;
+    for (int n = 0; n < settle + steps; n++) {
+        EulerIntegrator::step<System>(s, k, h);
+        if (!(std::fabs(s.x * c.x) <= 12.0 && std::fabs(s.y * c.y) <= 12.0 && std::fabs(s.z * c.z) <= 12.0))
+            return string::f("// %s: diverges at the middle of the knobs\nstatic constexpr const float* %s = nullptr;\n", (name + (lf ? " LF" : " HF")).c_str(), var.c_str());
+        if (n < settle)
+            continue;
+        sum = madd(sum, 1.0, s);
+        if ((n - settle + 1) % perState == 0)
+            states.push_back(s);
+    }
+    const Vec3<double> mean{sum.x / steps, sum.y / steps, sum.z / steps};
+
+    std::string source = string::f("// %s %s: mean %.6g, %.6g, %.6g\nstatic constexpr float %s[WARM_STATES * 6] = {", name.c_str(), lf ? "LF" : "HF", mean.x, mean.y, mean.z, var.c_str());
+    for (const Vec3<double>& w : states)
+        source += string::f("\n    %.8gf, %.8gf, %.8gf, %.8gf, %.8gf, %.8gf,", w.x, w.y, w.z, w.x - mean.x, w.y - mean.y, w.z - mean.z);
+    source.pop_back();
+    return source + "\n};\n";
+}
+
+
+int warmStates(const std::string& path) {
+    std::string source =
+        "#pragma once\n"
+        "\n"
+        "\n"
+        "// Generated by `build/sweep --warm-states src/WarmStates.hpp`, see sweep/warm.cpp.\n"
+        "//\n"
+        "// States on the attractor of each system and range at the middle of the knobs, which the\n"
+        "// modules start and reset from instead of the initial conditions. Each entry is x, y, z\n"
+        "// and the output of a settled DC blocker there, the state minus the mean of the attractor.\n";
+    source += string::f("static const int WARM_STATES = %d;\n", STATES);
+    for (int lf = 0; lf < 2; lf++) {
+        source += "\n" + statesSource<Chua>("Chua", lf);
+        source += "\n" + statesSource<Rossler>("Rossler", lf);
+        source += "\n" + statesSource<Lorentz84>("Lorentz84", lf);
+    }
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return 1;
+    }
+    std::fputs(source.c_str(), f);
+    std::fclose(f);
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Tests of the recording file, run by `make test`. Returns 1 on failure.
+//
+// A recording longer than the mapped window must read back whole after close() writes the
+// header at the start of the file.
+#include "Recorder.hpp"
+#include <cstdio>
+
+
+static const char* const PATH = "build/test-recording.bin";
+static const uint64_t WORDS = (40 << 20) / sizeof(uint32_t);    // 40 MiB, a few windows
+
+
+static bool readBack(const RecordHeader& header) {
+    FILE* f = std::fopen(PATH, "rb");
+    if (!f) {
+        printf("recorder: cannot open %s\n", PATH);
+        return false;
+    }
+    RecordHeader h;
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1 && h.frames == header.frames;
+    if (!ok)
+        printf("recorder: header lost\n");
+    for (uint64_t i = 0; ok && i < WORDS; i++) {
+        uint32_t word;
+        if (std::fread(&word, sizeof(word), 1, f) != 1 || word != (uint32_t) i) {
+            printf("recorder: byte %llu of %llu lost\n", (unsigned long long) (sizeof(h) + i * sizeof(word)),
+                (unsigned long long) (sizeof(h) + WORDS * sizeof(word)));
+            ok = false;
+        }
+    }
+    if (ok && std::fgetc(f) != EOF) {
+        printf("recorder: file longer than what was written\n");
+        ok = false;
+    }
+    std::fclose(f);
+    return ok;
+}
+
+
+int main() {
+    RecordHeader header;
+    header.channels = 1;
+    MappedFile file;
+    if (!file.open(PATH)) {
+        printf("recorder: cannot create %s\n", PATH);
+        return 1;
+    }
+    file.write(&header, sizeof(header));
+    // Written in pieces that straddle the windows
+    std::vector<uint32_t> words(12345);
+    for (uint64_t i = 0; i < WORDS; i += words.size()) {
+        uint64_t n = std::min<uint64_t>(words.size(), WORDS - i);
+        for (uint64_t j = 0; j < n; j++)
+            words[j] = (uint32_t) (i + j);
+        if (!file.write(words.data(), n * sizeof(uint32_t))) {
+            printf("recorder: write failed at %llu\n", (unsigned long long) file.size);
+            return 1;
+        }
+    }
+    header.frames = WORDS / 3;
+    file.close(&header, sizeof(header));
+
+    bool ok = readBack(header);
+    std::remove(PATH);
+    printf("recorder: %s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}